@@ -1,12 +1,60 @@
 #include "binary_image.hpp"
+#include "row_kernels.hpp"
 #include <cmath>
 #include <algorithm>
+#include <functional>
 
-BinaryImage::BinaryImage(int width, int height, bool fill_value)
+namespace {
+    constexpr int kWordsPerAlignment =
+        static_cast<int>(BinaryImage::kRowAlignment / sizeof(BinaryImage::Word));
+
+    int alignWords(int words) {
+        return (words + kWordsPerAlignment - 1) / kWordsPerAlignment * kWordsPerAlignment;
+    }
+
+    void setBit(BinaryImage::Word* row, int x, bool value) {
+        BinaryImage::Word& word = row[x >> 6];
+        BinaryImage::Word bit = BinaryImage::Word(1) << (x & (BinaryImage::kWordBits - 1));
+        word = value ? (word | bit) : (word & ~bit);
+    }
+
+    // a = a op b, row by row, for images of the same size
+    void combineImages(BinaryImage& a, const BinaryImageView& b, RowOp op) {
+        if (a.width() != b.width() || a.height() != b.height() || a.rowWords() == 0) {
+            return;
+        }
+
+        const RowKernels& kernels = rowKernels();
+        int words = a.rowWords();
+        std::vector<BinaryImage::Word> buffer(words);
+        for (int y = 0; y < a.height(); ++y) {
+            BinaryImage::Word* out = a.row(y);
+            kernels.combine(op, out, out, b.alignedRow(y, buffer.data()), words);
+            // b may carry right border pixels past its width
+            out[words - 1] &= a.rowTailMask();
+        }
+    }
+}
+
+BinaryImage::BinaryImage(int width, int height, bool fill_value, int border)
     : width_(width)
     , height_(height)
-    , pixels_(width * height, fill_value)
+    , border_(std::max(0, border))
+    , border_words_(alignWords((border_ + kWordBits - 1) / kWordBits))
+    , row_words_((width + kWordBits - 1) / kWordBits)
+    , stride_(border_words_ + alignWords((width + border_ + kWordBits - 1) / kWordBits))
+    , tail_mask_(width % kWordBits == 0 ? ~Word(0) : (Word(1) << (width % kWordBits)) - 1)
+    , words_(static_cast<std::size_t>(stride_) * (height + 2 * border_), 0)
 {
+    if (fill_value) {
+        fill(true);
+    }
+}
+
+BinaryImage::BinaryImage(const BinaryImageView& view, int border)
+    : BinaryImage(view.width(), view.height(), false, border)
+{
+    assign(view);
 }
 
 bool BinaryImage::get(int x, int y) const {
@@ -15,27 +63,204 @@ bool BinaryImage::get(int x, int y) const {
     if (x < 0 || x >= width_ || y < 0 || y >= height_) {
         return false;
     }
-    return pixels_[y * width_ + x];
+    return (row(y)[x / kWordBits] >> (x % kWordBits)) & 1;
 }
 
 void BinaryImage::set(int x, int y, bool value) {
     if (x >= 0 && x < width_ && y >= 0 && y < height_) {
-        pixels_[y * width_ + x] = value;
+        Word& word = row(y)[x / kWordBits];
+        Word bit = Word(1) << (x % kWordBits);
+        word = value ? (word | bit) : (word & ~bit);
     }
 }
 
 void BinaryImage::clear() {
-    std::fill(pixels_.begin(), pixels_.end(), false);
+    std::fill(words_.begin(), words_.end(), 0);
 }
 
 void BinaryImage::fill(bool value) {
-    std::fill(pixels_.begin(), pixels_.end(), value);
+    if (!value) {
+        clear();
+        return;
+    }
+
+    // Only the pixel bits are set; row padding stays zero
+    for (int y = 0; y < height_; ++y) {
+        Word* words = row(y);
+        std::fill(words, words + row_words_, ~Word(0));
+        if (row_words_ > 0) {
+            words[row_words_ - 1] &= tail_mask_;
+        }
+    }
 }
 
 BinaryImage BinaryImage::clone() const {
-    BinaryImage copy(width_, height_);
-    copy.pixels_ = pixels_;
-    return copy;
+    return *this;
+}
+
+BinaryImageView BinaryImage::view(int x, int y, int width, int height) const {
+    return BinaryImageView(*this).subView(x, y, width, height);
+}
+
+void BinaryImage::assign(const BinaryImageView& view) {
+    // A view of this image would be read after its rows are overwritten or
+    // freed, so it is copied out first unless it covers the whole image
+    const Word* data = view.height() > 0 ? view.rowData(0) : nullptr;
+    std::less<const Word*> before;
+    if (data && !before(data, words_.data()) && before(data, words_.data() + words_.size())) {
+        bool whole = data == row(0) && view.bitOffset() == 0 && view.stride() == stride_ &&
+                     view.width() == width_ && view.height() == height_;
+        if (!whole) {
+            *this = BinaryImage(view, border_);
+        }
+        return;
+    }
+
+    if (width_ != view.width() || height_ != view.height()) {
+        *this = BinaryImage(view.width(), view.height(), false, border_);
+    }
+    for (int y = 0; y < height_; ++y) {
+        view.copyRow(y, row(y));
+    }
+}
+
+bool BinaryImage::operator==(const BinaryImageView& other) const {
+    if (width_ != other.width() || height_ != other.height()) {
+        return false;
+    }
+
+    // The last word is masked since it may hold right border pixels
+    std::vector<Word> buffer(row_words_);
+    for (int y = 0; y < height_; ++y) {
+        const Word* a = row(y);
+        const Word* b = other.alignedRow(y, buffer.data());
+        if (row_words_ == 0) {
+            break;
+        }
+        if (!std::equal(a, a + row_words_ - 1, b) ||
+            ((a[row_words_ - 1] ^ b[row_words_ - 1]) & tail_mask_) != 0) {
+            return false;
+        }
+    }
+    return true;
+}
+
+BinaryImage& BinaryImage::operator&=(const BinaryImageView& other) {
+    combineImages(*this, other, RowOp::And);
+    return *this;
+}
+
+BinaryImage& BinaryImage::operator|=(const BinaryImageView& other) {
+    combineImages(*this, other, RowOp::Or);
+    return *this;
+}
+
+BinaryImage& BinaryImage::operator^=(const BinaryImageView& other) {
+    combineImages(*this, other, RowOp::Xor);
+    return *this;
+}
+
+BinaryImage& BinaryImage::subtract(const BinaryImageView& other) {
+    combineImages(*this, other, RowOp::AndNot);
+    return *this;
+}
+
+void BinaryImage::fillBorder(BoundaryMode mode) {
+    if (border_ == 0 || width_ == 0 || height_ == 0) {
+        return;
+    }
+
+    // Left and right border of every image row
+    for (int y = 0; y < height_; ++y) {
+        Word* words = row(y);
+        for (int i = 1; i <= border_; ++i) {
+            int left = -i;
+            int right = width_ - 1 + i;
+            switch (mode) {
+                case BoundaryMode::Zero:
+                case BoundaryMode::One:
+                    setBit(words, left, mode == BoundaryMode::One);
+                    setBit(words, right, mode == BoundaryMode::One);
+                    break;
+                case BoundaryMode::Extend:
+                    setBit(words, left, getUnchecked(0, y));
+                    setBit(words, right, getUnchecked(width_ - 1, y));
+                    break;
+                case BoundaryMode::Wrap:
+                    setBit(words, left, getUnchecked(((left % width_) + width_) % width_, y));
+                    setBit(words, right, getUnchecked(right % width_, y));
+                    break;
+            }
+        }
+    }
+
+    // Rows above and below, corners included. Whole rows are copied from
+    // the source row, whose horizontal border is already in place.
+    int first = -border_;
+    int last = width_ + border_;
+    for (int i = 1; i <= border_; ++i) {
+        for (int y : {-i, height_ - 1 + i}) {
+            Word* words = row(y);
+            switch (mode) {
+                case BoundaryMode::Zero:
+                case BoundaryMode::One:
+                    for (int x = first; x < last; ++x) {
+                        setBit(words, x, mode == BoundaryMode::One);
+                    }
+                    break;
+                case BoundaryMode::Extend:
+                case BoundaryMode::Wrap: {
+                    int source = mode == BoundaryMode::Extend
+                        ? std::clamp(y, 0, height_ - 1)
+                        : ((y % height_) + height_) % height_;
+                    const Word* src = row(source) - border_words_;
+                    std::copy(src, src + stride_, words - border_words_);
+                    break;
+                }
+            }
+        }
+    }
+}
+
+BinaryImage BinaryImage::withBorder(int border) const {
+    return BinaryImageView(*this).withBorder(border);
+}
+
+void BinaryImageView::copyRow(int y, Word* out) const {
+    int words = rowWords();
+    if (words == 0) {
+        return;
+    }
+
+    const Word* src = rowData(y);
+    if (bit_offset_ == 0) {
+        rowKernels().copy(out, src, words);
+    } else {
+        // Word i takes its high bits from the next word, which is only
+        // read when it holds pixels of the row
+        int last = (bit_offset_ + width_ - 1) / kWordBits;
+        for (int i = 0; i < words; ++i) {
+            Word next = i + 1 <= last ? src[i + 1] : 0;
+            out[i] = (src[i] >> bit_offset_) | (next << (kWordBits - bit_offset_));
+        }
+    }
+    out[words - 1] &= rowTailMask();
+}
+
+BinaryImageView BinaryImageView::subView(int x, int y, int width, int height) const {
+    int x0 = std::clamp(x, 0, width_);
+    int y0 = std::clamp(y, 0, height_);
+    int x1 = std::clamp(x + std::max(0, width), x0, width_);
+    int y1 = std::clamp(y + std::max(0, height), y0, height_);
+    return BinaryImageView(rowData(y0), x1 - x0, y1 - y0, stride_, bit_offset_ + x0);
+}
+
+BinaryImage BinaryImageView::withBorder(int border) const {
+    BinaryImage result(width_, height_, false, border);
+    for (int y = 0; y < height_; ++y) {
+        copyRow(y, result.row(y));
+    }
+    return result;
 }
 
 BinaryImage BinaryImage::createRectangle(int width, int height, int margin) {
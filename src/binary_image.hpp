@@ -3,23 +3,90 @@
 
 #include <vector>
 #include <cstdint>
+#include <cstddef>
+#include <new>
 #include <string>
 
+/**
+ * @brief Minimal allocator returning storage aligned to a fixed boundary.
+ *
+ * Used for the packed pixel words so that every row starts on a cache line
+ * and can be loaded with aligned vector instructions.
+ */
+template <typename T, std::size_t Alignment>
+struct AlignedAllocator {
+    using value_type = T;
+
+    template <typename U>
+    struct rebind { using other = AlignedAllocator<U, Alignment>; };
+
+    AlignedAllocator() = default;
+    template <typename U>
+    AlignedAllocator(const AlignedAllocator<U, Alignment>&) {}
+
+    T* allocate(std::size_t n) {
+        return static_cast<T*>(::operator new(n * sizeof(T), std::align_val_t(Alignment)));
+    }
+
+    void deallocate(T* p, std::size_t) {
+        ::operator delete(p, std::align_val_t(Alignment));
+    }
+
+    template <typename U>
+    bool operator==(const AlignedAllocator<U, Alignment>&) const { return true; }
+    template <typename U>
+    bool operator!=(const AlignedAllocator<U, Alignment>&) const { return false; }
+};
+
+/**
+ * @brief Boundary handling modes for morphological operations.
+ */
+enum class BoundaryMode {
+    Zero,      ///< Out-of-bounds pixels are treated as 0 (background)
+    One,       ///< Out-of-bounds pixels are treated as 1 (foreground)
+    Extend,    ///< Extend edge pixels (clamp to nearest border pixel)
+    Wrap       ///< Wrap around to opposite edge (periodic boundary)
+};
+
+class BinaryImageView;
+
 /**
  * @brief Represents a binary image (black and white only).
  * 
  * Each pixel is either 0 (background/black) or 1 (foreground/white).
  * This is the fundamental data structure for morphological operations.
+ *
+ * Pixels are bit-packed row by row into 64-bit words: pixel x of a row lives
+ * in bit (x % 64) of word (x / 64). Every row starts on a 64-byte boundary
+ * and occupies stride() words, so kernels can process 64 pixels per word
+ * operation. Bits past width() are always kept at zero.
+ *
+ * An image may also carry a guard border of border() pixels on every side.
+ * fillBorder() materializes a BoundaryMode into it, after which kernels can
+ * read any pixel up to border() outside the image with getUnchecked() and
+ * no boundary logic. The bits past width() then hold the right border.
  */
 class BinaryImage {
 public:
+    using Word = uint64_t;
+    static constexpr int kWordBits = 64;
+    static constexpr std::size_t kRowAlignment = 64;  ///< Row alignment in bytes
+
     /**
      * @brief Construct a new Binary Image with given dimensions.
      * @param width Image width in pixels
      * @param height Image height in pixels
      * @param fill_value Initial value for all pixels (default: false/0)
+     * @param border Guard border width in pixels (default: none)
+     */
+    BinaryImage(int width, int height, bool fill_value = false, int border = 0);
+
+    /**
+     * @brief Copy the pixels of a view into a new image.
+     * @param view Pixels to copy
+     * @param border Guard border width in pixels (default: none)
      */
-    BinaryImage(int width, int height, bool fill_value = false);
+    explicit BinaryImage(const BinaryImageView& view, int border = 0);
 
     /**
      * @brief Get pixel value at specified position.
@@ -29,6 +96,16 @@ public:
      */
     bool get(int x, int y) const;
 
+    /**
+     * @brief Get pixel value without bounds checking.
+     * @param x Column index, must be in [-border, width + border)
+     * @param y Row index, must be in [-border, height + border)
+     */
+    bool getUnchecked(int x, int y) const {
+        // Arithmetic shift floors negative border columns
+        return (row(y)[x >> 6] >> (x & (kWordBits - 1))) & 1;
+    }
+
     /**
      * @brief Set pixel value at specified position.
      * @param x Column index
@@ -49,6 +126,74 @@ public:
      */
     int height() const { return height_; }
 
+    /**
+     * @brief Number of words that hold pixels in each row.
+     * @return ceil(width / 64)
+     */
+    int rowWords() const { return row_words_; }
+
+    /**
+     * @brief Distance between consecutive rows, in words.
+     *
+     * Always >= rowWords() and padded so that each row stays aligned.
+     */
+    int stride() const { return stride_; }
+
+    /**
+     * @brief Mask of the valid pixel bits in the last word of a row.
+     */
+    Word rowTailMask() const { return tail_mask_; }
+
+    /**
+     * @brief Guard border width in pixels.
+     */
+    int border() const { return border_; }
+
+    /**
+     * @brief Get the packed words of a row.
+     * @param y Row index (-border to height+border-1), not bounds checked
+     * @return Pointer to rowWords() words of pixel data
+     *
+     * Writers must keep the bits past width() cleared (see rowTailMask()),
+     * except for fillBorder() writing the right border.
+     */
+    Word* row(int y) { return words_.data() + rowOffset(y); }
+    const Word* row(int y) const { return words_.data() + rowOffset(y); }
+
+    /**
+     * @brief Write the guard border according to a boundary mode.
+     *
+     * Costs O(border * perimeter). The border is not kept in sync with
+     * later pixel writes; call this again after modifying the image.
+     */
+    void fillBorder(BoundaryMode mode);
+
+    /**
+     * @brief Copy of this image with a different guard border.
+     * @param border Guard border width in pixels
+     * @return Image with the same pixels and a cleared border
+     */
+    BinaryImage withBorder(int border) const;
+
+    /**
+     * @brief View of a rectangle of this image, without copying.
+     * @param x, y Top-left pixel of the rectangle
+     * @param width, height Size of the rectangle
+     * @return View clipped to the image; valid while the image is alive
+     *         and not resized
+     */
+    BinaryImageView view(int x, int y, int width, int height) const;
+
+    /**
+     * @brief Replace the pixels by those of a view.
+     *
+     * Reuses the storage when the size matches, otherwise the image takes
+     * the view's size and keeps its border width. The view may be a view
+     * of this image: it is then copied into new storage first, and views
+     * taken from the image before the call are no longer valid.
+     */
+    void assign(const BinaryImageView& view);
+
     /**
      * @brief Clear the image (set all pixels to background).
      */
@@ -66,6 +211,27 @@ public:
      */
     BinaryImage clone() const;
 
+    /**
+     * @brief Compare dimensions and pixel content.
+     */
+    bool operator==(const BinaryImageView& other) const;
+    bool operator!=(const BinaryImageView& other) const { return !(*this == other); }
+
+    /**
+     * @brief Pixel-wise AND, OR and XOR with an image or view of the same size.
+     *
+     * Work a row of words at a time. An image of a different size leaves
+     * this one unchanged.
+     */
+    BinaryImage& operator&=(const BinaryImageView& other);
+    BinaryImage& operator|=(const BinaryImageView& other);
+    BinaryImage& operator^=(const BinaryImageView& other);
+
+    /**
+     * @brief Clear the pixels that are set in another image (this AND NOT other).
+     */
+    BinaryImage& subtract(const BinaryImageView& other);
+
     // Factory methods to create sample images for demonstration
 
     /**
@@ -116,9 +282,134 @@ public:
                                    float threshold = 0.5f, unsigned int seed = 42);
 
 private:
+    std::size_t rowOffset(int y) const {
+        return static_cast<std::size_t>(y + border_) * stride_ + border_words_;
+    }
+
+    int width_;
+    int height_;
+    int border_;
+    int border_words_;  // Words before pixel 0 of each row, a multiple of the row alignment
+    int row_words_;
+    int stride_;
+    Word tail_mask_;
+    std::vector<Word, AlignedAllocator<Word, kRowAlignment>> words_;  // Row-major, stride_ words per row, border rows included
+};
+
+/**
+ * @brief Non-owning, read-only window onto bit-packed pixel rows.
+ *
+ * Describes a rectangle of a larger image without copying it: row y starts
+ * at bit bitOffset() of the word rowData(y), and consecutive rows are
+ * stride() words apart. Every BinaryImage converts to a view of itself, so
+ * functions taking a view accept both.
+ *
+ * A view whose bit offset is 0 (rectangles starting at a multiple of 64
+ * pixels) exposes its rows as they are; other views are realigned a row at
+ * a time by copyRow(). The words past the right edge belong to the
+ * underlying image and are never read as pixels of the view.
+ */
+class BinaryImageView {
+public:
+    using Word = BinaryImage::Word;
+    static constexpr int kWordBits = BinaryImage::kWordBits;
+
+    /**
+     * @brief View onto raw packed rows.
+     * @param data Word holding pixel (0, 0)
+     * @param width, height Size in pixels
+     * @param stride Distance between rows, in words
+     * @param bit_offset Bit of pixel (0, 0) within data, any value >= 0
+     */
+    BinaryImageView(const Word* data, int width, int height, int stride, int bit_offset = 0)
+        : data_(data + bit_offset / kWordBits)
+        , width_(width)
+        , height_(height)
+        , stride_(stride)
+        , bit_offset_(bit_offset % kWordBits)
+    {
+    }
+
+    /**
+     * @brief View of a whole image.
+     */
+    BinaryImageView(const BinaryImage& image)
+        : BinaryImageView(image.row(0), image.width(), image.height(), image.stride())
+    {
+    }
+
+    int width() const { return width_; }
+    int height() const { return height_; }
+    int stride() const { return stride_; }
+    int bitOffset() const { return bit_offset_; }
+
+    /**
+     * @brief Number of words of a row realigned to bit 0.
+     * @return ceil(width / 64)
+     */
+    int rowWords() const { return (width_ + kWordBits - 1) / kWordBits; }
+
+    /**
+     * @brief Mask of the valid pixel bits in the last realigned word.
+     */
+    Word rowTailMask() const {
+        return width_ % kWordBits == 0 ? ~Word(0) : (Word(1) << (width_ % kWordBits)) - 1;
+    }
+
+    /**
+     * @brief Word holding pixel 0 of row y, at bit bitOffset().
+     * @param y Row index, not bounds checked
+     */
+    const Word* rowData(int y) const { return data_ + static_cast<std::ptrdiff_t>(y) * stride_; }
+
+    /**
+     * @brief Get pixel value, false outside the view.
+     */
+    bool get(int x, int y) const {
+        if (x < 0 || x >= width_ || y < 0 || y >= height_) {
+            return false;
+        }
+        int bit = x + bit_offset_;
+        return (rowData(y)[bit / kWordBits] >> (bit % kWordBits)) & 1;
+    }
+
+    /**
+     * @brief Copy row y shifted to bit 0.
+     * @param y Row index, not bounds checked
+     * @param out Receives rowWords() words, bits past width() cleared
+     */
+    void copyRow(int y, Word* out) const;
+
+    /**
+     * @brief Row y shifted to bit 0, copied only when needed.
+     * @param buffer Room for rowWords() words, used when bitOffset() != 0
+     * @return rowData(y) for an aligned view, else buffer filled by
+     *         copyRow(). Bits past width() may be set in the former.
+     */
+    const Word* alignedRow(int y, Word* buffer) const {
+        if (bit_offset_ == 0) {
+            return rowData(y);
+        }
+        copyRow(y, buffer);
+        return buffer;
+    }
+
+    /**
+     * @brief View of a rectangle of this view, clipped to it.
+     */
+    BinaryImageView subView(int x, int y, int width, int height) const;
+
+    /**
+     * @brief Copy of the viewed pixels with a cleared guard border.
+     */
+    BinaryImage withBorder(int border) const;
+
+private:
+    const Word* data_;
     int width_;
     int height_;
-    std::vector<bool> pixels_;  // Row-major storage
+    int stride_;
+    int bit_offset_;
 };
 
 #endif // BINARY_IMAGE_HPP
@@ -0,0 +1,394 @@
+#include "connected_components.hpp"
+#include <algorithm>
+#include <atomic>
+#include <functional>
+
+namespace {
+    using Word = BinaryImage::Word;
+    constexpr int kWordBits = BinaryImage::kWordBits;
+
+    // Horizontal run [x0, x1) of component pixels in one row
+    struct Run {
+        int x0;
+        int x1;
+        int32_t label;  // Provisional label until the second pass
+    };
+
+    // Append the runs of `value` pixels in a row of packed words
+    void extractRuns(const Word* words, int row_words, Word tail_mask, bool value,
+                     int width, std::vector<Run>& runs) {
+        int open = -1;  // Start of a run that continues into the next word
+        for (int i = 0; i < row_words; ++i) {
+            Word w = value ? words[i] : ~words[i];
+            if (i == row_words - 1) {
+                w &= tail_mask;
+            }
+
+            int base = i * kWordBits;
+            int pos = 0;
+            while (pos < kWordBits) {
+                // Outside a run look for the next 1, inside for the next 0
+                Word rest = (open < 0 ? w : ~w) >> pos;
+                if (rest == 0) {
+                    break;
+                }
+                pos += __builtin_ctzll(rest);
+                if (open < 0) {
+                    open = base + pos;
+                } else {
+                    runs.push_back({open, base + pos, 0});
+                    open = -1;
+                }
+            }
+        }
+        if (open >= 0) {
+            runs.push_back({open, width, 0});
+        }
+    }
+
+    // Union-find over provisional labels. The root of a set is always its
+    // smallest label, i.e. the label created first in raster order.
+    int32_t findRoot(std::vector<int32_t>& parent, int32_t label) {
+        while (parent[label] != label) {
+            parent[label] = parent[parent[label]];
+            label = parent[label];
+        }
+        return label;
+    }
+
+    void unite(std::vector<int32_t>& parent, int32_t a, int32_t b) {
+        a = findRoot(parent, a);
+        b = findRoot(parent, b);
+        if (a < b) {
+            parent[b] = a;
+        } else if (b < a) {
+            parent[a] = b;
+        }
+    }
+
+    // The same union-find over global labels, shared by threads. A root is
+    // only ever linked below a smaller root with a CAS that fails if it
+    // stopped being a root, so the smallest-root invariant holds.
+    using SharedParents = std::vector<std::atomic<int32_t>>;
+
+    int32_t findRoot(const SharedParents& parent, int32_t label) {
+        int32_t next = parent[label].load(std::memory_order_acquire);
+        while (next != label) {
+            label = next;
+            next = parent[label].load(std::memory_order_acquire);
+        }
+        return label;
+    }
+
+    void unite(SharedParents& parent, int32_t a, int32_t b) {
+        while (true) {
+            a = findRoot(parent, a);
+            b = findRoot(parent, b);
+            if (a == b) {
+                return;
+            }
+            if (b < a) {
+                std::swap(a, b);
+            }
+            int32_t expected = b;
+            if (parent[b].compare_exchange_strong(expected, a, std::memory_order_acq_rel)) {
+                return;
+            }
+        }
+    }
+
+    // Visit the pairs of runs from two consecutive rows that touch
+    template <typename BelowRun, typename Visit>
+    void forEachOverlap(const Run* above, const Run* above_end, BelowRun* below,
+                        BelowRun* below_end, int reach, Visit visit) {
+        for (; below < below_end; ++below) {
+            while (above < above_end && above->x1 + reach <= below->x0) {
+                ++above;
+            }
+            for (const Run* k = above; k < above_end && k->x0 < below->x1 + reach; ++k) {
+                visit(*k, *below);
+            }
+        }
+    }
+
+    // Rows [y0, y1) labeled on their own. Labels are local to the strip,
+    // 1..parent.size() - 1, and become base + label globally.
+    struct Strip {
+        int y0 = 0;
+        int y1 = 0;
+        std::vector<Run> runs;
+        std::vector<size_t> row_start;  // y1 - y0 + 1 entries
+        std::vector<int32_t> parent;    // Local root of each local label
+        int32_t base = 0;
+    };
+
+    // First pass over a strip: runs of every row, each labeled after the
+    // first run it touches in the row above and united with the others.
+    // Diagonal neighbors extend the reach of a run by one pixel.
+    void labelStrip(const BinaryImageView& image, int reach, bool value, Strip& strip) {
+        int row_words = image.rowWords();
+        Word tail_mask = image.rowTailMask();
+        std::vector<Word> buffer(row_words);
+        std::vector<Run>& runs = strip.runs;
+        std::vector<int32_t>& parent = strip.parent;
+        strip.row_start.assign(strip.y1 - strip.y0 + 1, 0);
+        parent.assign(1, 0);
+        for (int y = strip.y0; y < strip.y1; ++y) {
+            size_t above = y > strip.y0 ? strip.row_start[y - 1 - strip.y0] : runs.size();
+            size_t begin = runs.size();
+            strip.row_start[y - strip.y0] = begin;
+            extractRuns(image.alignedRow(y, buffer.data()), row_words, tail_mask, value, image.width(), runs);
+
+            Run* data = runs.data();
+            forEachOverlap(data + above, data + begin, data + begin, data + runs.size(), reach,
+                           [&](const Run& a, Run& run) {
+                if (run.label == 0) {
+                    run.label = a.label;
+                } else {
+                    unite(parent, run.label, a.label);
+                }
+            });
+            for (size_t i = begin; i < runs.size(); ++i) {
+                if (runs[i].label == 0) {
+                    runs[i].label = static_cast<int32_t>(parent.size());
+                    parent.push_back(runs[i].label);
+                }
+            }
+        }
+        strip.row_start.back() = runs.size();
+
+        for (int32_t label = 1; label < static_cast<int32_t>(parent.size()); ++label) {
+            parent[label] = findRoot(parent, label);
+        }
+    }
+
+    // Integer sums of a component or part of one, exact in any order
+    struct PartialStats {
+        int64_t area = 0;
+        int min_x = 0;
+        int min_y = 0;
+        int max_x = 0;
+        int max_y = 0;
+        int64_t sum_x = 0;
+        int64_t sum_y = 0;
+
+        void add(const Run& run, int y) {
+            int64_t length = run.x1 - run.x0;
+            PartialStats part;
+            part.area = length;
+            part.min_x = run.x0;
+            part.max_x = run.x1 - 1;
+            part.min_y = y;
+            part.max_y = y;
+            part.sum_x = (static_cast<int64_t>(run.x0) + run.x1 - 1) * length / 2;
+            part.sum_y = static_cast<int64_t>(y) * length;
+            merge(part);
+        }
+
+        void merge(const PartialStats& other) {
+            if (other.area == 0) {
+                return;
+            }
+            if (area == 0) {
+                *this = other;
+                return;
+            }
+            area += other.area;
+            min_x = std::min(min_x, other.min_x);
+            min_y = std::min(min_y, other.min_y);
+            max_x = std::max(max_x, other.max_x);
+            max_y = std::max(max_y, other.max_y);
+            sum_x += other.sum_x;
+            sum_y += other.sum_y;
+        }
+    };
+}
+
+ComponentLabels::ComponentLabels(int width, int height)
+    : width_(width)
+    , height_(height)
+    , labels_(static_cast<size_t>(width) * height, 0)
+{
+}
+
+ComponentLabels ComponentLabels::compute(const BinaryImageView& image, Connectivity connectivity, bool value) {
+    ComponentLabels result;
+    result.relabel(image, connectivity, value);
+    return result;
+}
+
+void ComponentLabels::relabel(const BinaryImageView& image, Connectivity connectivity, bool value) {
+    int width = image.width();
+    int height = image.height();
+    width_ = width;
+    height_ = height;
+    labels_.resize(static_cast<size_t>(width) * height);
+    stats_.clear();
+    if (width == 0 || height == 0) {
+        return;
+    }
+
+    // A few strips per thread so uneven strips still balance
+    constexpr int kMinStripRows = 32;
+    int threads = getThreadCount();
+    int strip_count = threads == 1 ? 1 : std::max(1, std::min(threads * 4, height / kMinStripRows));
+    auto forEachStrip = [&](const std::function<void(int)>& task) {
+        if (pool_ && strip_count > 1) {
+            pool_->parallelFor(strip_count, task);
+        } else {
+            for (int s = 0; s < strip_count; ++s) {
+                task(s);
+            }
+        }
+    };
+
+    int reach = connectivity == Connectivity::Eight ? 1 : 0;
+    std::vector<Strip> strips(strip_count);
+    forEachStrip([&](int s) {
+        strips[s].y0 = static_cast<int>(static_cast<int64_t>(height) * s / strip_count);
+        strips[s].y1 = static_cast<int>(static_cast<int64_t>(height) * (s + 1) / strip_count);
+        labelStrip(image, reach, value, strips[s]);
+    });
+
+    // Global labels number the strips one after the other, which keeps
+    // them in raster order of creation
+    int32_t total = 0;
+    for (Strip& strip : strips) {
+        strip.base = total;
+        total += static_cast<int32_t>(strip.parent.size()) - 1;
+    }
+    SharedParents parent(static_cast<size_t>(total) + 1);
+    parent[0].store(0, std::memory_order_relaxed);
+    forEachStrip([&](int s) {
+        const Strip& strip = strips[s];
+        for (size_t label = 1; label < strip.parent.size(); ++label) {
+            parent[strip.base + label].store(strip.base + strip.parent[label], std::memory_order_relaxed);
+        }
+    });
+
+    // Unite the runs that touch across each seam; the pool's task hand-off
+    // orders these writes after the initialization above
+    if (strip_count > 1) {
+        pool_->parallelFor(strip_count - 1, [&](int seam) {
+            const Strip& upper = strips[seam];
+            const Strip& lower = strips[seam + 1];
+            const Run* last = upper.runs.data() + upper.row_start[upper.y1 - upper.y0 - 1];
+            const Run* first = lower.runs.data();
+            forEachOverlap(last, upper.runs.data() + upper.runs.size(), first, first + lower.row_start[1],
+                           reach, [&](const Run& a, const Run& b) {
+                unite(parent, upper.base + a.label, lower.base + b.label);
+            });
+        });
+    }
+
+    // Final labels in order of the global roots: count the roots of each
+    // strip, number them, then point every other label at its root
+    std::vector<int32_t> final_label(static_cast<size_t>(total) + 1, 0);
+    std::vector<int32_t> root_offset(strip_count + 1, 0);
+    forEachStrip([&](int s) {
+        const Strip& strip = strips[s];
+        int32_t roots = 0;
+        for (int32_t label = 1; label < static_cast<int32_t>(strip.parent.size()); ++label) {
+            roots += findRoot(parent, strip.base + label) == strip.base + label;
+        }
+        root_offset[s + 1] = roots;
+    });
+    for (int s = 0; s < strip_count; ++s) {
+        root_offset[s + 1] += root_offset[s];
+    }
+    forEachStrip([&](int s) {
+        const Strip& strip = strips[s];
+        int32_t next = root_offset[s];
+        for (int32_t label = strip.base + 1; label < strip.base + static_cast<int32_t>(strip.parent.size()); ++label) {
+            if (findRoot(parent, label) == label) {
+                final_label[label] = ++next;
+            }
+        }
+    });
+    forEachStrip([&](int s) {
+        const Strip& strip = strips[s];
+        for (int32_t label = strip.base + 1; label < strip.base + static_cast<int32_t>(strip.parent.size()); ++label) {
+            int32_t root = findRoot(parent, label);
+            if (root != label) {
+                final_label[label] = final_label[root];
+            }
+        }
+    });
+
+    // Second pass: write every label of each row, 0 between the runs, and
+    // sum the statistics of each strip by local root
+    std::vector<std::vector<PartialStats>> partials(strip_count);
+    forEachStrip([&](int s) {
+        const Strip& strip = strips[s];
+        std::vector<PartialStats>& partial = partials[s];
+        partial.resize(strip.parent.size());
+        for (int y = strip.y0; y < strip.y1; ++y) {
+            int32_t* out = labels_.data() + static_cast<size_t>(y) * width;
+            int x = 0;
+            for (size_t i = strip.row_start[y - strip.y0]; i < strip.row_start[y - strip.y0 + 1]; ++i) {
+                const Run& run = strip.runs[i];
+                std::fill(out + x, out + run.x0, 0);
+                std::fill(out + run.x0, out + run.x1, final_label[strip.base + run.label]);
+                x = run.x1;
+                partial[strip.parent[run.label]].add(run, y);
+            }
+            std::fill(out + x, out + width, 0);
+        }
+    });
+
+    // Merge the sums in strip order and derive the statistics
+    int32_t count = root_offset.back();
+    std::vector<PartialStats> sums(count);
+    for (int s = 0; s < strip_count; ++s) {
+        const Strip& strip = strips[s];
+        for (size_t label = 1; label < strip.parent.size(); ++label) {
+            if (partials[s][label].area > 0) {
+                sums[final_label[strip.base + label] - 1].merge(partials[s][label]);
+            }
+        }
+    }
+    stats_.resize(count);
+    for (int32_t i = 0; i < count; ++i) {
+        const PartialStats& sum = sums[i];
+        ComponentStats& stats = stats_[i];
+        stats.area = sum.area;
+        stats.min_x = sum.min_x;
+        stats.min_y = sum.min_y;
+        stats.max_x = sum.max_x;
+        stats.max_y = sum.max_y;
+        stats.centroid_x = static_cast<double>(sum.sum_x) / static_cast<double>(sum.area);
+        stats.centroid_y = static_cast<double>(sum.sum_y) / static_cast<double>(sum.area);
+    }
+}
+
+int32_t ComponentLabels::get(int x, int y) const {
+    if (x < 0 || x >= width_ || y < 0 || y >= height_) {
+        return 0;
+    }
+    return row(y)[x];
+}
+
+BinaryImage ComponentLabels::mask(int32_t label) const {
+    BinaryImage result(width_, height_, false);
+    for (int y = 0; y < height_; ++y) {
+        const int32_t* labels = row(y);
+        for (int x = 0; x < width_; ++x) {
+            if (labels[x] == label) {
+                result.set(x, y, true);
+            }
+        }
+    }
+    return result;
+}
+
+void ComponentLabels::setThreadCount(int threads) {
+    if (threads == 1) {
+        pool_.reset();
+    } else {
+        pool_ = std::make_shared<ThreadPool>(threads);
+    }
+}
+
+int ComponentLabels::getThreadCount() const {
+    return pool_ ? pool_->threadCount() : 1;
+}
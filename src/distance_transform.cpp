@@ -0,0 +1,199 @@
+#include "distance_transform.hpp"
+#include <algorithm>
+
+namespace {
+    // A parabola (p - q)^2 + f rooted at site q
+    struct Site {
+        int64_t q;
+        int64_t f;
+    };
+
+    int64_t floorDiv(int64_t a, int64_t b) {
+        int64_t q = a / b;
+        if (a % b != 0 && a < 0) {
+            --q;
+        }
+        return q;
+    }
+
+    uint32_t step(uint32_t d) {
+        return d == DistanceField::kInfinite ? d : d + 1;
+    }
+
+    /**
+     * Lower envelope of the parabolas of `sites` (sorted by q), sampled at
+     * p = 0..n-1. Sites may lie outside [0, n). Meijster's formulation:
+     * each stack entry owns the samples from start[k] up to the next entry.
+     */
+    void lowerEnvelope(const std::vector<Site>& sites, int n, uint32_t* out,
+                       std::vector<int>& owner, std::vector<int64_t>& start) {
+        if (sites.empty()) {
+            std::fill(out, out + n, DistanceField::kInfinite);
+            return;
+        }
+
+        auto eval = [&](int i, int64_t p) {
+            int64_t d = p - sites[i].q;
+            return d * d + sites[i].f;
+        };
+
+        owner.clear();
+        start.clear();
+        for (int i = 0; i < static_cast<int>(sites.size()); ++i) {
+            // Drop parabolas that the new one beats over their whole range
+            while (!owner.empty() && eval(owner.back(), start.back()) > eval(i, start.back())) {
+                owner.pop_back();
+                start.pop_back();
+            }
+
+            if (owner.empty()) {
+                owner.push_back(i);
+                start.push_back(0);
+                continue;
+            }
+
+            // First sample where the new parabola is strictly lower
+            const Site& a = sites[owner.back()];
+            const Site& b = sites[i];
+            int64_t first = 1 + floorDiv(b.q * b.q - a.q * a.q + b.f - a.f, 2 * (b.q - a.q));
+            if (first < n) {
+                owner.push_back(i);
+                start.push_back(first);
+            }
+        }
+
+        int k = static_cast<int>(owner.size()) - 1;
+        for (int p = n - 1; p >= 0; --p) {
+            out[p] = static_cast<uint32_t>(std::min<int64_t>(eval(owner[k], p), DistanceField::kInfinite - 1));
+            if (p == start[k]) {
+                --k;
+            }
+        }
+    }
+}
+
+DistanceField::DistanceField(int width, int height)
+    : width_(width)
+    , height_(height)
+    , values_(static_cast<size_t>(width) * height, kInfinite)
+{
+}
+
+uint32_t DistanceField::get(int x, int y) const {
+    if (x < 0 || x >= width_ || y < 0 || y >= height_) {
+        return kInfinite;
+    }
+    return row(y)[x];
+}
+
+DistanceField DistanceField::compute(const BinaryImage& image, BoundaryMode boundary, bool feature_value) {
+    int w = image.width();
+    int h = image.height();
+    DistanceField field(w, h);
+    if (w == 0 || h == 0) {
+        return field;
+    }
+
+    // Outside pixels are features only for a constant boundary of the
+    // feature value. Extend never adds a feature closer than the edge pixel
+    // it replicates, so it behaves like "no outside features".
+    bool outside_features = (boundary == BoundaryMode::Zero && !feature_value) ||
+                            (boundary == BoundaryMode::One && feature_value);
+    bool periodic = boundary == BoundaryMode::Wrap;
+
+    // Phase 1: vertical 1-D distance (unsquared), scanned row by row
+    uint32_t edge = outside_features ? 0 : kInfinite;
+    for (int y = 0; y < h; ++y) {
+        const BinaryImage::Word* words = image.row(y);
+        uint32_t* cur = field.row(y);
+        const uint32_t* prev = y > 0 ? field.row(y - 1) : nullptr;
+        for (int x = 0; x < w; ++x) {
+            bool value = (words[x / BinaryImage::kWordBits] >> (x % BinaryImage::kWordBits)) & 1;
+            if (value == feature_value) {
+                cur[x] = 0;
+            } else {
+                cur[x] = step(prev ? prev[x] : edge);
+            }
+        }
+    }
+    if (periodic) {
+        // Second lap carries distances across the bottom/top seam
+        for (int y = 0; y < h; ++y) {
+            uint32_t* cur = field.row(y);
+            const uint32_t* prev = field.row((y + h - 1) % h);
+            for (int x = 0; x < w; ++x) {
+                cur[x] = std::min(cur[x], step(prev[x]));
+            }
+        }
+    }
+    for (int lap = 0; lap < (periodic ? 2 : 1); ++lap) {
+        for (int y = h - 1; y >= 0; --y) {
+            uint32_t* cur = field.row(y);
+            const uint32_t* next = nullptr;
+            if (y < h - 1) {
+                next = field.row(y + 1);
+            } else if (periodic) {
+                next = field.row(0);
+            }
+            for (int x = 0; x < w; ++x) {
+                cur[x] = std::min(cur[x], step(next ? next[x] : edge));
+            }
+        }
+    }
+
+    // Phase 2: lower envelope of parabolas along each row
+    std::vector<Site> sites;
+    std::vector<int> owner;
+    std::vector<int64_t> start;
+    for (int y = 0; y < h; ++y) {
+        uint32_t* cur = field.row(y);
+
+        sites.clear();
+        if (outside_features) {
+            sites.push_back({-1, 0});
+        }
+        for (int copy = periodic ? -1 : 0; copy <= (periodic ? 1 : 0); ++copy) {
+            for (int x = 0; x < w; ++x) {
+                if (cur[x] != kInfinite) {
+                    int64_t g = cur[x];
+                    sites.push_back({x + static_cast<int64_t>(copy) * w, g * g});
+                }
+            }
+        }
+        if (outside_features) {
+            sites.push_back({w, 0});
+        }
+
+        lowerEnvelope(sites, w, cur, owner, start);
+    }
+
+    return field;
+}
+
+BinaryImage DistanceField::farther(uint64_t squared_limit) const {
+    BinaryImage result(width_, height_, false);
+    for (int y = 0; y < height_; ++y) {
+        const uint32_t* values = row(y);
+        BinaryImage::Word* words = result.row(y);
+        for (int x = 0; x < width_; ++x) {
+            if (values[x] > squared_limit) {
+                words[x / BinaryImage::kWordBits] |= BinaryImage::Word(1) << (x % BinaryImage::kWordBits);
+            }
+        }
+    }
+    return result;
+}
+
+BinaryImage DistanceField::within(uint64_t squared_limit) const {
+    BinaryImage result(width_, height_, false);
+    for (int y = 0; y < height_; ++y) {
+        const uint32_t* values = row(y);
+        BinaryImage::Word* words = result.row(y);
+        for (int x = 0; x < width_; ++x) {
+            if (values[x] <= squared_limit) {
+                words[x / BinaryImage::kWordBits] |= BinaryImage::Word(1) << (x % BinaryImage::kWordBits);
+            }
+        }
+    }
+    return result;
+}
@@ -0,0 +1,77 @@
+#ifndef DISTANCE_TRANSFORM_HPP
+#define DISTANCE_TRANSFORM_HPP
+
+#include "binary_image.hpp"
+#include <vector>
+#include <cstdint>
+
+/**
+ * @brief Exact squared Euclidean distance from every pixel to the nearest
+ * feature pixel.
+ *
+ * Computed in linear time with the two-phase Meijster/Felzenszwalb
+ * algorithm: per-column 1-D distances, then a lower envelope of parabolas
+ * along each row. Thresholding one field answers disk erosion or dilation
+ * queries for every radius in O(W*H).
+ */
+class DistanceField {
+public:
+    /// Value stored for pixels that have no feature pixel at all
+    static constexpr uint32_t kInfinite = UINT32_MAX;
+
+    /**
+     * @brief Construct a field with every value set to kInfinite.
+     * @param width Field width in pixels
+     * @param height Field height in pixels
+     */
+    DistanceField(int width = 0, int height = 0);
+
+    /**
+     * @brief Compute the distance field of an image.
+     * @param image Source image
+     * @param boundary What lies outside the image, with the same meaning as
+     *        in Morphology (Zero/One: constant, Extend: replicated edge,
+     *        Wrap: periodic image)
+     * @param feature_value Pixels with this value are the features
+     *        (default: distance to the nearest background pixel)
+     * @return Squared distances, kInfinite where no feature exists
+     */
+    static DistanceField compute(const BinaryImage& image,
+                                 BoundaryMode boundary = BoundaryMode::Zero,
+                                 bool feature_value = false);
+
+    /**
+     * @brief Get squared distance at a position.
+     * @return Squared distance, or kInfinite for out-of-bounds positions
+     */
+    uint32_t get(int x, int y) const;
+
+    int width() const { return width_; }
+    int height() const { return height_; }
+
+    const uint32_t* row(int y) const { return values_.data() + static_cast<size_t>(y) * width_; }
+    uint32_t* row(int y) { return values_.data() + static_cast<size_t>(y) * width_; }
+
+    /**
+     * @brief Pixels whose squared distance is strictly greater than a limit.
+     *
+     * With background features this is the erosion by a disk of radius r
+     * for squared_limit = r*r.
+     */
+    BinaryImage farther(uint64_t squared_limit) const;
+
+    /**
+     * @brief Pixels whose squared distance is at most a limit.
+     *
+     * With foreground features this is the dilation by a disk of radius r
+     * for squared_limit = r*r.
+     */
+    BinaryImage within(uint64_t squared_limit) const;
+
+private:
+    int width_;
+    int height_;
+    std::vector<uint32_t> values_;  // Row-major, width_ values per row
+};
+
+#endif // DISTANCE_TRANSFORM_HPP
@@ -1,5 +1,885 @@
 #include "erosion.hpp"
+#include "morphology_kernels.hpp"
+#include "row_kernels.hpp"
+#include "step_budget.hpp"
+#include "tile_map.hpp"
 #include <algorithm>
+#include <cstdlib>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <unordered_map>
+
+namespace {
+    using Word = BinaryImage::Word;
+    constexpr int kWordBits = BinaryImage::kWordBits;
+
+    // Scratch rows start on cache lines like BinaryImage rows, so vector
+    // loads and stores never split across two lines
+    using WordBuffer = std::vector<Word, AlignedAllocator<Word, BinaryImage::kRowAlignment>>;
+    constexpr int kAlignmentWords = static_cast<int>(BinaryImage::kRowAlignment / sizeof(Word));
+
+    int alignedWords(int words) {
+        return (words + kAlignmentWords - 1) / kAlignmentWords * kAlignmentWords;
+    }
+
+    // SE offsets that share one row (dy), as sorted unique dx values
+    struct SeRow {
+        int dy;
+        std::vector<int> dxs;
+    };
+
+    std::vector<SeRow> groupOffsetsByRow(const std::vector<std::pair<int, int>>& offsets) {
+        std::map<int, std::vector<int>> by_row;
+        for (const auto& [dx, dy] : offsets) {
+            by_row[dy].push_back(dx);
+        }
+
+        std::vector<SeRow> rows;
+        rows.reserve(by_row.size());
+        for (auto& [dy, dxs] : by_row) {
+            std::sort(dxs.begin(), dxs.end());
+            dxs.erase(std::unique(dxs.begin(), dxs.end()), dxs.end());
+            rows.push_back({dy, std::move(dxs)});
+        }
+        return rows;
+    }
+
+    int horizontalReach(const std::vector<std::pair<int, int>>& offsets) {
+        int reach = 0;
+        for (const auto& [dx, dy] : offsets) {
+            reach = std::max(reach, std::abs(dx));
+        }
+        return reach;
+    }
+
+    /**
+     * Row buffer where every row carries `margin` extra pixels on each
+     * side, filled according to the boundary mode. Rows outside the image
+     * resolve to a clamped/wrapped row or to a constant row, so kernels can
+     * read any neighbor without bounds checks. Holds either a copy of the
+     * input or the result of an intermediate pass, in caller-owned storage
+     * that is resized and cleared but keeps its capacity.
+     */
+    class PaddedRows {
+    public:
+        PaddedRows(WordBuffer& storage, int width, int height, int margin, BoundaryMode boundary)
+            : width_(width)
+            , height_(height)
+            , boundary_(boundary)
+            , margin_(margin)
+            , margin_words_(alignedWords((margin + kWordBits - 1) / kWordBits))
+            , stride_(margin_words_ + alignedWords((width + margin + kWordBits - 1) / kWordBits + 1))
+        {
+            storage.assign(static_cast<size_t>(stride_) * (height_ + 2), 0);
+            words_ = storage.data();
+            // Two constant rows after the image rows: all zeros, all ones
+            std::fill(rowStart(height_ + 1), rowStart(height_ + 2), ~Word(0));
+        }
+
+        // Copy input rows [y0, y1) and materialize their horizontal margins
+        void load(const BinaryImageView& input, int y0, int y1) {
+            for (int y = y0; y < y1; ++y) {
+                Word* dst = mutableRow(y);
+                input.copyRow(y, dst);
+
+                for (int i = 1; i <= margin_; ++i) {
+                    setBit(dst, -i, outsidePixel(input, -i, y));
+                    setBit(dst, width_ - 1 + i, outsidePixel(input, width_ - 1 + i, y));
+                }
+            }
+        }
+
+        // Pointer to the word holding pixel 0 of logical row y (any y)
+        const Word* row(int y) const {
+            if (y < 0 || y >= height_) {
+                switch (boundary_) {
+                    case BoundaryMode::Zero:
+                        return rowStart(height_) + margin_words_;
+                    case BoundaryMode::One:
+                        return rowStart(height_ + 1) + margin_words_;
+                    case BoundaryMode::Extend:
+                        y = std::clamp(y, 0, height_ - 1);
+                        break;
+                    case BoundaryMode::Wrap:
+                        y = ((y % height_) + height_) % height_;
+                        break;
+                }
+            }
+            return rowStart(y) + margin_words_;
+        }
+
+        // Writable pixel words of image row y (0 <= y < height)
+        Word* mutableRow(int y) { return rowStart(y) + margin_words_; }
+
+        // Words before pixel 0 and total words readable around each row
+        int marginWords() const { return margin_words_; }
+        int stride() const { return stride_; }
+
+    private:
+        Word* rowStart(int index) { return words_ + static_cast<size_t>(index) * stride_; }
+        const Word* rowStart(int index) const { return words_ + static_cast<size_t>(index) * stride_; }
+
+        static void setBit(Word* row, int x, bool value) {
+            int s = x & (kWordBits - 1);
+            int w = (x - s) / kWordBits;
+            Word bit = Word(1) << s;
+            row[w] = value ? (row[w] | bit) : (row[w] & ~bit);
+        }
+
+        // Value of a horizontally out-of-bounds pixel on an in-bounds row
+        bool outsidePixel(const BinaryImageView& input, int x, int y) const {
+            switch (boundary_) {
+                case BoundaryMode::Zero:
+                    return false;
+                case BoundaryMode::One:
+                    return true;
+                case BoundaryMode::Extend:
+                    return input.get(std::clamp(x, 0, width_ - 1), y);
+                case BoundaryMode::Wrap:
+                    return input.get(((x % width_) + width_) % width_, y);
+            }
+            return false;
+        }
+
+        int width_;
+        int height_;
+        BoundaryMode boundary_;
+        int margin_;
+        int margin_words_;
+        int stride_;
+        Word* words_;  // Rows of the caller's storage
+    };
+
+    // Erosion (AND) or dilation (OR) of one output row over every SE term.
+    // Rows is PaddedRows or another source with the same row layout.
+    template <typename Rows>
+    void accumulateRow(const Rows& padded, const std::vector<SeRow>& se_rows,
+                       int y, int words, bool erode, Word* acc) {
+        const RowKernels& kernels = rowKernels();
+        RowOp op = erode ? RowOp::And : RowOp::Or;
+        kernels.fill(acc, erode ? ~Word(0) : Word(0), words);
+        for (const SeRow& se_row : se_rows) {
+            const Word* row = padded.row(y + se_row.dy);
+            for (int dx : se_row.dxs) {
+                kernels.combineShifted(op, acc, acc, row, words, dx);
+            }
+        }
+    }
+
+    // Erosion and dilation of one output row together, reading each
+    // shifted SE term once
+    template <typename Rows>
+    void accumulateRowMinMax(const Rows& padded, const std::vector<SeRow>& se_rows,
+                             int y, int words, Word* eroded, Word* dilated) {
+        const RowKernels& kernels = rowKernels();
+        kernels.fill(eroded, ~Word(0), words);
+        kernels.fill(dilated, 0, words);
+        for (const SeRow& se_row : se_rows) {
+            const Word* row = padded.row(y + se_row.dy);
+            for (int dx : se_row.dxs) {
+                kernels.minMaxShifted(eroded, dilated, row, words, dx);
+            }
+        }
+    }
+
+    /**
+     * Eroded and/or dilated words of output row y from any padded row
+     * source, with the unrolled kernel when the shape has one. `rows` is
+     * scratch for the fixed kernel's row pointers.
+     */
+    template <typename Rows>
+    void erodeDilateRow(const Rows& src, const std::vector<SeRow>& se_rows,
+                        const ShapeRowKernels* fixed, std::vector<const Word*>& rows,
+                        int y, int words, bool need_erosion, bool need_dilation,
+                        Word* eroded, Word* dilated) {
+        if (fixed) {
+            for (int k = 0; k < static_cast<int>(rows.size()); ++k) {
+                rows[k] = src.row(y + k - fixed->reach);
+            }
+            if (need_erosion && need_dilation) {
+                fixed->minMax(rows.data(), words, eroded, dilated);
+            } else if (need_erosion) {
+                fixed->erode(rows.data(), words, eroded);
+            } else if (need_dilation) {
+                fixed->dilate(rows.data(), words, dilated);
+            }
+        } else if (need_erosion && need_dilation) {
+            accumulateRowMinMax(src, se_rows, y, words, eroded, dilated);
+        } else if (need_erosion) {
+            accumulateRow(src, se_rows, y, words, true, eroded);
+        } else if (need_dilation) {
+            accumulateRow(src, se_rows, y, words, false, dilated);
+        }
+    }
+
+    // Segments at least this long use the length-independent line kernels
+    constexpr int kLineKernelMinLength = 5;
+
+    /**
+     * Erosion (AND) or dilation (OR) of one padded row by the horizontal
+     * segment [x0, x0 + length). Uses logarithmic doubling in the bit
+     * domain, p_2m(x) = p_m(x) op p_m(x + m), then combines two
+     * overlapping windows of the largest power of two <= length. Cost is
+     * O(log length) word operations per 64 pixels.
+     */
+    void horizontalLine(const PaddedRows& src, int y, int x0, int length, int words,
+                        bool erode, Word* out, WordBuffer& a, WordBuffer& b) {
+        const RowKernels& kernels = rowKernels();
+        RowOp op = erode ? RowOp::And : RowOp::Or;
+
+        int lead = src.marginWords();
+        int span = src.stride();
+        int size = span + length / kWordBits + 2;
+        a.resize(size);
+        b.resize(size);
+        kernels.copy(a.data(), src.row(y) - lead, span);
+        kernels.fill(a.data() + span, 0, size - span);
+        kernels.fill(b.data() + span, 0, size - span);
+
+        int m = 1;
+        while (2 * m <= length) {
+            kernels.combineShifted(op, b.data(), a.data(), a.data(), span, m);
+            a.swap(b);
+            m *= 2;
+        }
+
+        const Word* p = a.data() + lead;
+        kernels.fill(out, erode ? ~Word(0) : Word(0), words);
+        kernels.combineShifted(op, out, out, p, words, x0);
+        kernels.combineShifted(op, out, out, p, words, x0 + length - m);
+    }
+
+    /**
+     * Van Herk/Gil-Werman erosion (AND) or dilation (OR) of output rows
+     * [y_begin, y_end) by the vertical segment [y0, y0 + length). The source
+     * rows the range needs (its halo included) are split into blocks of
+     * `length` rows; a backward pass stores block suffixes and a forward
+     * pass keeps the running block prefix, so each output word costs three
+     * word operations whatever the segment length. Row y is written to
+     * dst + y * dst_stride. `scratch` holds vanHerkScratchWords() words.
+     */
+    void vanHerkVertical(const PaddedRows& src, int y_begin, int y_end, int y0, int length,
+                         int words, bool erode, Word* dst, int dst_stride, Word* scratch) {
+        const RowKernels& kernels = rowKernels();
+        RowOp op = erode ? RowOp::And : RowOp::Or;
+        int first = y_begin + y0;                    // First source row needed
+        int count = y_end - y_begin + length - 1;    // Source rows needed in total
+        int stride = alignedWords(words);
+        Word* suffix = scratch;
+        Word* prefix = scratch + static_cast<size_t>(count) * stride;
+
+        // Backward pass: suffix within each block
+        for (int t = count - 1; t >= 0; --t) {
+            const Word* in = src.row(first + t);
+            Word* cur = suffix + static_cast<size_t>(t) * stride;
+            if (t % length == length - 1 || t == count - 1) {
+                kernels.copy(cur, in, words);
+            } else {
+                kernels.combine(op, cur, in, cur + stride, words);
+            }
+        }
+
+        // Forward pass: running prefix, combined with the suffix that
+        // starts length - 1 rows earlier
+        for (int u = 0; u < count; ++u) {
+            const Word* in = src.row(first + u);
+            if (u % length == 0) {
+                kernels.copy(prefix, in, words);
+            } else {
+                kernels.combine(op, prefix, prefix, in, words);
+            }
+
+            int t = u - length + 1;
+            if (t >= 0) {
+                const Word* suf = suffix + static_cast<size_t>(t) * stride;
+                Word* out = dst + static_cast<size_t>(y_begin + t) * dst_stride;
+                kernels.combine(op, out, suf, prefix, words);
+            }
+        }
+    }
+
+    // Scratch of vanHerkVertical() for at most `rows` output rows: the
+    // block suffixes of every source row, then the running prefix
+    size_t vanHerkScratchWords(int rows, int length, int words) {
+        return static_cast<size_t>(rows + length) * alignedWords(words);
+    }
+
+    // Combine the eroded/dilated words of one row into the requested operation
+    void writeOperationRow(MorphOperation op, const Word* original, const Word* eroded,
+                           const Word* dilated, Word* out, int words, Word tail_mask) {
+        switch (op) {
+            case MorphOperation::Erosion:
+                rowKernels().copy(out, eroded, words);
+                break;
+            case MorphOperation::Dilation:
+                rowKernels().copy(out, dilated, words);
+                break;
+            case MorphOperation::InnerBoundary:
+                rowKernels().combine(RowOp::AndNot, out, original, eroded, words);
+                break;
+            case MorphOperation::OuterBoundary:
+                rowKernels().combine(RowOp::AndNot, out, dilated, original, words);
+                break;
+            case MorphOperation::Gradient:
+                rowKernels().combine(RowOp::Xor, out, dilated, eroded, words);
+                break;
+            default:
+                rowKernels().copy(out, original, words);
+                break;
+        }
+
+        // Shifted-in margin bits must not leak past the image width
+        out[words - 1] &= tail_mask;
+    }
+
+    bool needsErosion(MorphOperation op) {
+        return op == MorphOperation::Erosion ||
+               op == MorphOperation::InnerBoundary ||
+               op == MorphOperation::Gradient;
+    }
+
+    bool needsDilation(MorphOperation op) {
+        return op == MorphOperation::Dilation ||
+               op == MorphOperation::OuterBoundary ||
+               op == MorphOperation::Gradient;
+    }
+
+    // Probe into an image whose guard border covers the SE reach
+    struct PaddedProbe {
+        const BinaryImage& input;
+
+        bool operator()(int x, int y) const {
+            return input.getUnchecked(x, y);
+        }
+    };
+
+    // Same logic as Morphology::checkPixel, over an arbitrary probe
+    template <typename Probe>
+    bool evaluatePixel(MorphOperation op, const std::vector<std::pair<int, int>>& offsets,
+                       const Probe& probe, int x, int y) {
+        auto eroded = [&] {
+            for (const auto& [dx, dy] : offsets) {
+                if (!probe(x + dx, y + dy)) return false;
+            }
+            return true;
+        };
+        auto dilated = [&] {
+            for (const auto& [dx, dy] : offsets) {
+                if (probe(x + dx, y + dy)) return true;
+            }
+            return false;
+        };
+        auto mixed = [&] {
+            if (offsets.empty()) return true;
+            bool first = probe(x + offsets[0].first, y + offsets[0].second);
+            for (size_t k = 1; k < offsets.size(); ++k) {
+                if (probe(x + offsets[k].first, y + offsets[k].second) != first) return true;
+            }
+            return false;
+        };
+
+        switch (op) {
+            case MorphOperation::Erosion:
+                return eroded();
+            case MorphOperation::Dilation:
+                return dilated();
+            case MorphOperation::InnerBoundary:
+                return probe(x, y) && !eroded();
+            case MorphOperation::OuterBoundary:
+                return !probe(x, y) && dilated();
+            case MorphOperation::Gradient:
+                return mixed();
+            default:
+                return probe(x, y);
+        }
+    }
+
+    /**
+     * Per-pixel engine for rows [y0, y1). `padded` has its border filled
+     * for the boundary mode, so every probe is a plain unchecked read.
+     */
+    void perPixelRows(const BinaryImage& padded, BinaryImage& output, MorphOperation op,
+                      const std::vector<std::pair<int, int>>& offsets, int y0, int y1) {
+        PaddedProbe probe{padded};
+        int width = padded.width();
+        for (int y = y0; y < y1; ++y) {
+            Word* out = output.row(y);
+            Word bits = 0;
+            for (int x = 0; x < width; ++x) {
+                bits |= Word(evaluatePixel(op, offsets, probe, x, y)) << (x % kWordBits);
+                if (x % kWordBits == kWordBits - 1 || x == width - 1) {
+                    out[x / kWordBits] = bits;
+                    bits = 0;
+                }
+            }
+        }
+    }
+
+    /**
+     * One output row of a 3x3 table operator. `padded` has a filled border
+     * of at least one pixel; the window index keeps the last three columns,
+     * the newest in the low bits.
+     */
+    void lutRow(const BinaryImage& padded, const NeighborhoodLut& lut, int y, Word* out) {
+        const Word* above = padded.row(y - 1);
+        const Word* center = padded.row(y);
+        const Word* below = padded.row(y + 1);
+        auto column = [&](int x) {
+            int w = x >> 6;
+            int s = x & (kWordBits - 1);
+            return static_cast<unsigned>(((above[w] >> s) & 1) | ((center[w] >> s) & 1) << 1 |
+                                         ((below[w] >> s) & 1) << 2);
+        };
+
+        int width = padded.width();
+        unsigned index = column(-1) << 3 | column(0);
+        Word bits = 0;
+        for (int x = 0; x < width; ++x) {
+            index = ((index << 3) | column(x + 1)) & 511;
+            bits |= Word(lut[index]) << (x % kWordBits);
+            if (x % kWordBits == kWordBits - 1 || x == width - 1) {
+                out[x / kWordBits] = bits;
+                bits = 0;
+            }
+        }
+    }
+
+    // Bounding box of an SE whose offsets fill it completely
+    struct SeRect {
+        int x0, x1, y0, y1;
+    };
+
+    bool findRectangle(const std::vector<std::pair<int, int>>& offsets, SeRect& rect) {
+        if (offsets.empty()) {
+            return false;
+        }
+
+        rect = {offsets[0].first, offsets[0].first, offsets[0].second, offsets[0].second};
+        for (const auto& [dx, dy] : offsets) {
+            rect.x0 = std::min(rect.x0, dx);
+            rect.x1 = std::max(rect.x1, dx);
+            rect.y0 = std::min(rect.y0, dy);
+            rect.y1 = std::max(rect.y1, dy);
+        }
+
+        // Separable only if every position of the box is covered
+        std::vector<std::pair<int, int>> unique_offsets(offsets);
+        std::sort(unique_offsets.begin(), unique_offsets.end());
+        unique_offsets.erase(std::unique(unique_offsets.begin(), unique_offsets.end()),
+                             unique_offsets.end());
+        size_t box = static_cast<size_t>(rect.x1 - rect.x0 + 1) * (rect.y1 - rect.y0 + 1);
+        return unique_offsets.size() == box;
+    }
+
+    /**
+     * An operation as chains of erosion/dilation passes. The results of the
+     * two chains take the eroded and dilated roles of `finish`, a single-pass
+     * operation, so writeOperationRow() combines them with the original. A
+     * chain is empty when `finish` does not read it.
+     */
+    struct ChainPlan {
+        std::vector<MorphOperation> eroded;
+        std::vector<MorphOperation> dilated;
+        MorphOperation finish;
+    };
+
+    bool isSinglePass(MorphOperation op) {
+        return op == MorphOperation::Erosion ||
+               op == MorphOperation::Dilation ||
+               op == MorphOperation::InnerBoundary ||
+               op == MorphOperation::OuterBoundary ||
+               op == MorphOperation::Gradient;
+    }
+
+    ChainPlan chainPlan(MorphOperation op, int iterations) {
+        std::vector<MorphOperation> erode(iterations, MorphOperation::Erosion);
+        std::vector<MorphOperation> dilate(iterations, MorphOperation::Dilation);
+        std::vector<MorphOperation> opening(erode);
+        opening.insert(opening.end(), dilate.begin(), dilate.end());
+        std::vector<MorphOperation> closing(dilate);
+        closing.insert(closing.end(), erode.begin(), erode.end());
+
+        switch (op) {
+            case MorphOperation::Dilation:
+                return {{}, dilate, op};
+            case MorphOperation::InnerBoundary:
+                return {erode, {}, op};
+            case MorphOperation::OuterBoundary:
+                return {{}, dilate, op};
+            case MorphOperation::Gradient:
+                return {erode, dilate, op};
+            case MorphOperation::Opening:
+                return {{}, opening, MorphOperation::Dilation};
+            case MorphOperation::Closing:
+                return {closing, {}, MorphOperation::Erosion};
+            case MorphOperation::WhiteTopHat:
+                return {opening, {}, MorphOperation::InnerBoundary};
+            case MorphOperation::BlackTopHat:
+                return {{}, closing, MorphOperation::OuterBoundary};
+            default:
+                return {erode, {}, MorphOperation::Erosion};
+        }
+    }
+
+    /**
+     * Value of image pixel (x, y) after the first `count` passes of a chain,
+     * each pass reading the previous result through the boundary mode.
+     * Memoized by pass and pixel, so a query costs the SE size times the
+     * cone of pixels it depends on rather than the SE size to the power of
+     * the pass count.
+     */
+    bool chainPixel(const BinaryImageView& input, const std::vector<std::pair<int, int>>& offsets,
+                    BoundaryMode boundary, const std::vector<MorphOperation>& passes, int count,
+                    int x, int y, std::unordered_map<int64_t, bool>& memo) {
+        if (count == 0) {
+            return input.get(x, y);
+        }
+
+        int w = input.width();
+        int h = input.height();
+        int64_t key = (static_cast<int64_t>(count) * h + y) * w + x;
+        auto cached = memo.find(key);
+        if (cached != memo.end()) {
+            return cached->second;
+        }
+
+        // Erosion stays 1 until it meets a 0, dilation stays 0 until a 1
+        bool erode = passes[count - 1] == MorphOperation::Erosion;
+        bool result = erode;
+        for (const auto& [dx, dy] : offsets) {
+            int sx = x + dx;
+            int sy = y + dy;
+            bool value;
+            if (sx >= 0 && sx < w && sy >= 0 && sy < h) {
+                value = chainPixel(input, offsets, boundary, passes, count - 1, sx, sy, memo);
+            } else if (boundary == BoundaryMode::Zero || boundary == BoundaryMode::One) {
+                value = boundary == BoundaryMode::One;
+            } else {
+                if (boundary == BoundaryMode::Extend) {
+                    sx = std::clamp(sx, 0, w - 1);
+                    sy = std::clamp(sy, 0, h - 1);
+                } else {
+                    sx = ((sx % w) + w) % w;
+                    sy = ((sy % h) + h) % h;
+                }
+                value = chainPixel(input, offsets, boundary, passes, count - 1, sx, sy, memo);
+            }
+            if (value != erode) {
+                result = !erode;
+                break;
+            }
+        }
+
+        memo.emplace(key, result);
+        return result;
+    }
+
+    /**
+     * The most recent rows of one pass of a streamed chain: a ring of
+     * `slots` rows laid out like PaddedRows. Rows outside the image resolve
+     * to a constant row (Zero, One) or to the clamped edge row (Extend).
+     * Wrap is not supported, it needs the far edge of a pass first.
+     */
+    class RingRows {
+    public:
+        RingRows(int width, int height, int margin, BoundaryMode boundary, int slots)
+            : width_(width)
+            , height_(height)
+            , boundary_(boundary)
+            , slots_(slots)
+            , row_words_((width + kWordBits - 1) / kWordBits)
+            , margin_words_(alignedWords((margin + kWordBits - 1) / kWordBits))
+            , stride_(margin_words_ + alignedWords((width + margin + kWordBits - 1) / kWordBits + 1))
+            , tail_mask_(width % kWordBits == 0 ? ~Word(0) : (Word(1) << (width % kWordBits)) - 1)
+            , words_(static_cast<size_t>(stride_) * (slots + 2), 0)
+        {
+            // Two constant rows after the ring: all zeros, all ones
+            std::fill(rowStart(slots_ + 1), rowStart(slots_ + 2), ~Word(0));
+        }
+
+        // Pointer to the word holding pixel 0 of logical row y. Image rows
+        // must be among the last `slots` rows written.
+        const Word* row(int y) const {
+            if (y < 0 || y >= height_) {
+                switch (boundary_) {
+                    case BoundaryMode::One:
+                        return rowStart(slots_ + 1) + margin_words_;
+                    case BoundaryMode::Extend:
+                        y = std::clamp(y, 0, height_ - 1);
+                        break;
+                    default:
+                        return rowStart(slots_) + margin_words_;
+                }
+            }
+            return rowStart(y % slots_) + margin_words_;
+        }
+
+        // Pixel words of image row y; call finishRow(y) once they are written
+        Word* mutableRow(int y) { return rowStart(y % slots_) + margin_words_; }
+
+        // Clear the bits past the width, then write both margins
+        void finishRow(int y) {
+            Word* row = mutableRow(y);
+            Word& last = row[row_words_ - 1];
+            Word left = 0;
+            Word right = 0;
+            if (boundary_ == BoundaryMode::One) {
+                left = ~Word(0);
+                right = ~Word(0);
+            } else if (boundary_ == BoundaryMode::Extend) {
+                left = (row[0] & 1) ? ~Word(0) : 0;
+                right = ((last >> ((width_ - 1) % kWordBits)) & 1) ? ~Word(0) : 0;
+            }
+            last = (last & tail_mask_) | (right & ~tail_mask_);
+            std::fill(row - margin_words_, row, left);
+            std::fill(row + row_words_, row - margin_words_ + stride_, right);
+        }
+
+    private:
+        Word* rowStart(int index) { return words_.data() + static_cast<size_t>(index) * stride_; }
+        const Word* rowStart(int index) const { return words_.data() + static_cast<size_t>(index) * stride_; }
+
+        int width_;
+        int height_;
+        BoundaryMode boundary_;
+        int slots_;
+        int row_words_;
+        int margin_words_;
+        int stride_;
+        Word tail_mask_;
+        WordBuffer words_;
+    };
+
+    /**
+     * Input rows streamed through an erosion/dilation chain in raster
+     * order. Stage 0 copies the input rows a band needs into a ring with
+     * margins; every following stage computes one pass from the previous
+     * ring. Each ring keeps only the window of rows its reader needs, so
+     * neither the input copy nor intermediate rows grow with the image and
+     * the rows between passes stay in cache. A band recomputes the halo
+     * rows it shares with its neighbors.
+     */
+    class ChainStream {
+    public:
+        /**
+         * @param passes Erosion/dilation passes, possibly none
+         * @param read_lo, read_hi Rows y + read_lo .. y + read_hi of the last
+         *        stage are read together for output row y
+         * @param y_begin, y_end Output rows the caller will ask for
+         */
+        ChainStream(const BinaryImageView& input, const std::vector<MorphOperation>& passes,
+                    const std::vector<SeRow>& se_rows, const ShapeRowKernels* fixed,
+                    int margin, BoundaryMode boundary, int read_lo, int read_hi,
+                    int y_begin, int y_end)
+            : input_(input)
+            , passes_(passes)
+            , se_rows_(se_rows)
+            , fixed_(fixed)
+            , height_(input.height())
+            , words_(input.rowWords())
+            , dy_min_(se_rows.empty() ? 0 : se_rows.front().dy)
+            , dy_max_(se_rows.empty() ? 0 : se_rows.back().dy)
+            , read_hi_(read_hi)
+            , rows_(fixed ? 2 * fixed->reach + 1 : 0)
+        {
+            // Rows each stage computes for its reader, from the last stage back
+            int count = static_cast<int>(passes.size()) + 1;
+            std::vector<std::pair<int, int>> ranges(count);
+            int begin = std::clamp(y_begin + read_lo, 0, height_ - 1);
+            int end = std::clamp(y_end - 1 + read_hi, 0, height_ - 1) + 1;
+            for (int k = count - 1; k >= 0; --k) {
+                ranges[k] = {begin, end};
+                begin = std::clamp(begin + dy_min_, 0, height_ - 1);
+                end = std::clamp(end - 1 + dy_max_, 0, height_ - 1) + 1;
+            }
+
+            stages_.reserve(count);
+            for (int k = 0; k < count; ++k) {
+                int window = k + 1 < count ? dy_max_ - dy_min_ + 1 : read_hi - read_lo + 1;
+                RingRows rows(input.width(), height_, margin, boundary, window);
+                stages_.push_back({std::move(rows), ranges[k].first, ranges[k].second});
+            }
+        }
+
+        // Last stage with the read window of output row y readable; y must
+        // not decrease between calls
+        const RingRows& rowsFor(int y) {
+            int last = static_cast<int>(stages_.size()) - 1;
+            advance(last, std::clamp(y + read_hi_, 0, height_ - 1));
+            return stages_[last].rows;
+        }
+
+        // Whether input row y is no longer read, i.e. may be overwritten
+        bool released(int y) const {
+            return y < stages_[0].next || y >= stages_[0].end;
+        }
+
+    private:
+        struct Stage {
+            RingRows rows;
+            int next;  // Next row to compute
+            int end;   // One past the last row to compute
+        };
+
+        // Compute the rows of stage k up to row y
+        void advance(int k, int y) {
+            Stage& stage = stages_[k];
+            for (; stage.next <= y && stage.next < stage.end; ++stage.next) {
+                int t = stage.next;
+                Word* out = stage.rows.mutableRow(t);
+                if (k == 0) {
+                    input_.copyRow(t, out);
+                } else {
+                    advance(k - 1, std::clamp(t + dy_max_, 0, height_ - 1));
+                    bool erode = passes_[k - 1] == MorphOperation::Erosion;
+                    erodeDilateRow(stages_[k - 1].rows, se_rows_, fixed_, rows_, t, words_,
+                                   erode, !erode, out, out);
+                }
+                stage.rows.finishRow(t);
+            }
+        }
+
+        BinaryImageView input_;
+        const std::vector<MorphOperation>& passes_;
+        const std::vector<SeRow>& se_rows_;
+        const ShapeRowKernels* fixed_;
+        int height_;
+        int words_;
+        int dy_min_;
+        int dy_max_;
+        int read_hi_;
+        std::vector<const Word*> rows_;
+        std::vector<Stage> stages_;
+    };
+
+    // Rows of another row source, starting at word `word` of each row
+    template <typename Rows>
+    struct OffsetRows {
+        const Rows& rows;
+        int word;
+
+        const Word* row(int y) const { return rows.row(y) + word; }
+    };
+
+    // Words [begin, end) of an output row, computed or resolved as one
+    struct WordRun {
+        int begin;
+        int end;
+        TileState state;  // Mixed: compute, otherwise the value of every pixel
+    };
+
+    /**
+     * Splits output rows into word runs that the tile map resolves and
+     * runs that need the kernels. A word resolves when every pixel its SE
+     * footprints can read, outside pixels included, has the same value:
+     * erosion and dilation both give that value there. Rows whose footprint
+     * covers the same tile rows share one split.
+     */
+    class TileSkip {
+    public:
+        static constexpr int kMinSkipWords = 16;
+
+        TileSkip(const TileMap& tiles, int width, int height, BoundaryMode boundary,
+                 const std::vector<std::pair<int, int>>& offsets)
+            : tiles_(tiles)
+            , width_(width)
+            , height_(height)
+            , boundary_(boundary)
+        {
+            dx_min_ = dx_max_ = offsets.front().first;
+            dy_min_ = dy_max_ = offsets.front().second;
+            for (const auto& [dx, dy] : offsets) {
+                dx_min_ = std::min(dx_min_, dx);
+                dx_max_ = std::max(dx_max_, dx);
+                dy_min_ = std::min(dy_min_, dy);
+                dy_max_ = std::max(dy_max_, dy);
+            }
+        }
+
+        const std::vector<WordRun>& runs(int y) {
+            Span rows = span(y + dy_min_, y + dy_max_, height_);
+            Span key{rows.first / TileMap::kTileSize, rows.last / TileMap::kTileSize, rows.outside};
+            if (valid_ && key.first == key_.first && key.last == key_.last && key.outside == key_.outside) {
+                return runs_;
+            }
+            valid_ = true;
+            key_ = key;
+
+            runs_.clear();
+            int words = tiles_.tilesX();
+            for (int i = 0; i < words; ++i) {
+                Span cols = span(i * kWordBits + dx_min_,
+                                 std::min(i * kWordBits + kWordBits - 1, width_ - 1) + dx_max_, width_);
+                TileState state = TileState::Mixed;
+                if (cols.first <= cols.last && rows.first <= rows.last) {
+                    state = tiles_.blockState(cols.first / TileMap::kTileSize, key.first,
+                                              cols.last / TileMap::kTileSize, key.last);
+                    if ((rows.outside || cols.outside) && state != outsideState()) {
+                        state = TileState::Mixed;
+                    }
+                } else {
+                    state = outsideState();
+                }
+
+                if (!runs_.empty() && runs_.back().state == state) {
+                    runs_.back().end = i + 1;
+                } else {
+                    runs_.push_back({i, i + 1, state});
+                }
+            }
+
+            // Short resolved runs are cheaper to compute than to split
+            // the kernel calls around
+            std::vector<WordRun> merged;
+            for (WordRun run : runs_) {
+                if (run.state != TileState::Mixed && run.end - run.begin < kMinSkipWords) {
+                    run.state = TileState::Mixed;
+                }
+                if (!merged.empty() && merged.back().state == run.state) {
+                    merged.back().end = run.end;
+                } else {
+                    merged.push_back(run);
+                }
+            }
+            runs_.swap(merged);
+            return runs_;
+        }
+
+    private:
+        // Pixel range [first, last] inside [0, size) that a read range
+        // covers, and whether it also reads a constant outside value.
+        // Extend clamps, so it never reads anything but image pixels.
+        struct Span {
+            int first;
+            int last;
+            bool outside;
+        };
+
+        Span span(int first, int last, int size) const {
+            if (boundary_ == BoundaryMode::Extend) {
+                return {std::clamp(first, 0, size - 1), std::clamp(last, 0, size - 1), false};
+            }
+            return {std::max(first, 0), std::min(last, size - 1), first < 0 || last >= size};
+        }
+
+        TileState outsideState() const {
+            return boundary_ == BoundaryMode::One ? TileState::Full : TileState::Empty;
+        }
+
+        const TileMap& tiles_;
+        int width_;
+        int height_;
+        BoundaryMode boundary_;
+        int dx_min_;
+        int dx_max_;
+        int dy_min_;
+        int dy_max_;
+        bool valid_ = false;
+        Span key_{0, 0, false};
+        std::vector<WordRun> runs_;
+    };
+}
 
 StructuringElement StructuringElement::createSquare(int size) {
     StructuringElement se;
@@ -44,14 +924,42 @@ StructuringElement StructuringElement::createCross(int size) {
     return se;
 }
 
+StructuringElement StructuringElement::createDisk(int radius) {
+    StructuringElement se;
+    se.width = 2 * radius + 1;
+    se.height = 2 * radius + 1;
+    se.center_x = radius;
+    se.center_y = radius;
+
+    for (int dy = -radius; dy <= radius; ++dy) {
+        for (int dx = -radius; dx <= radius; ++dx) {
+            if (dx * dx + dy * dy <= radius * radius) {
+                se.offsets.emplace_back(dx, dy);
+            }
+        }
+    }
+
+    return se;
+}
+
 Morphology::Morphology(const StructuringElement& se, MorphOperation op, BoundaryMode boundary)
     : se_(se)
     , operation_(op)
     , boundary_(boundary)
 {
+    // The shapes the visualizer offers, plus small disks
+    FixedShape shape;
+    if (morphology_kernels::findFixedShape(se_.offsets, shape)) {
+        fixed_shape_ = static_cast<int>(shape);
+    }
 }
 
-bool Morphology::getPixelWithBoundary(const BinaryImage& input, int x, int y) const {
+const ShapeRowKernels* Morphology::fixedShapeKernel() const {
+    // Looked up per call so setSimdLevel() takes effect
+    return fixed_shape_ < 0 ? nullptr : &rowKernels().shapes[fixed_shape_];
+}
+
+bool Morphology::getPixelWithBoundary(const BinaryImageView& input, int x, int y) const {
     int w = input.width();
     int h = input.height();
 
@@ -81,7 +989,7 @@ bool Morphology::getPixelWithBoundary(const BinaryImage& input, int x, int y) co
     }
 }
 
-bool Morphology::checkErosion(const BinaryImage& input, int x, int y) const {
+bool Morphology::checkErosion(const BinaryImageView& input, int x, int y) const {
     // Erosion: output=1 only if ALL pixels under SE are 1
     for (const auto& [dx, dy] : se_.offsets) {
         if (!getPixelWithBoundary(input, x + dx, y + dy)) {
@@ -91,7 +999,7 @@ bool Morphology::checkErosion(const BinaryImage& input, int x, int y) const {
     return true;
 }
 
-bool Morphology::checkDilation(const BinaryImage& input, int x, int y) const {
+bool Morphology::checkDilation(const BinaryImageView& input, int x, int y) const {
     // Dilation: output=1 if ANY pixel under SE is 1
     for (const auto& [dx, dy] : se_.offsets) {
         if (getPixelWithBoundary(input, x + dx, y + dy)) {
@@ -101,9 +1009,55 @@ bool Morphology::checkDilation(const BinaryImage& input, int x, int y) const {
     return false;
 }
 
-bool Morphology::checkPixel(const BinaryImage& input, int x, int y) const {
-    bool original = input.get(x, y);
-    
+bool Morphology::checkGradient(const BinaryImageView& input, int x, int y) const {
+    // Gradient: dilation and erosion differ exactly when the footprint
+    // holds both a 1 and a 0, so one walk answers both, stopping at the
+    // first pixel that differs from the first one. An empty SE erodes to
+    // 1 and dilates to 0.
+    if (se_.offsets.empty()) {
+        return true;
+    }
+    const auto& offsets = se_.offsets;
+    bool first = getPixelWithBoundary(input, x + offsets[0].first, y + offsets[0].second);
+    for (size_t k = 1; k < offsets.size(); ++k) {
+        if (getPixelWithBoundary(input, x + offsets[k].first, y + offsets[k].second) != first) {
+            return true;
+        }
+    }
+    return false;
+}
+
+bool Morphology::checkChained(const BinaryImageView& input, int x, int y) const {
+    ChainPlan plan = chainPlan(operation_, iterations_);
+    auto chain = [&](const std::vector<MorphOperation>& passes) {
+        std::unordered_map<int64_t, bool> memo;
+        int count = static_cast<int>(passes.size());
+        return chainPixel(input, se_.offsets, boundary_, passes, count, x, y, memo);
+    };
+
+    switch (plan.finish) {
+        case MorphOperation::Erosion:
+            return chain(plan.eroded);
+
+        case MorphOperation::Dilation:
+            return chain(plan.dilated);
+
+        case MorphOperation::InnerBoundary:
+            return input.get(x, y) && !chain(plan.eroded);
+
+        case MorphOperation::OuterBoundary:
+            return !input.get(x, y) && chain(plan.dilated);
+
+        default:
+            return chain(plan.dilated) != chain(plan.eroded);
+    }
+}
+
+bool Morphology::checkPixel(const BinaryImageView& input, int x, int y) const {
+    if (iterations_ > 1 || !isSinglePass(operation_)) {
+        return checkChained(input, x, y);
+    }
+
     switch (operation_) {
         case MorphOperation::Erosion:
             return checkErosion(input, x, y);
@@ -114,35 +1068,515 @@ bool Morphology::checkPixel(const BinaryImage& input, int x, int y) const {
         case MorphOperation::InnerBoundary:
             // Inner boundary: Original AND NOT Eroded
             // Pixels that are in original but would be eroded
-            return original && !checkErosion(input, x, y);
+            return input.get(x, y) && !checkErosion(input, x, y);
 
         case MorphOperation::OuterBoundary:
             // Outer boundary: Dilated AND NOT Original
             // Pixels that are added by dilation
-            return checkDilation(input, x, y) && !original;
+            return !input.get(x, y) && checkDilation(input, x, y);
 
         case MorphOperation::Gradient:
             // Morphological gradient: Dilated XOR Eroded
             // Full edge (both inner and outer)
-            return checkDilation(input, x, y) != checkErosion(input, x, y);
+            return checkGradient(input, x, y);
 
         default:
-            return original;
+            return input.get(x, y);
     }
 }
 
-BinaryImage Morphology::apply(const BinaryImage& input) const {
+BinaryImage Morphology::apply(const BinaryImageView& input) const {
     BinaryImage output(input.width(), input.height(), false);
+    apply(input, output);
+    return output;
+}
+
+void Morphology::apply(const BinaryImageView& input, BinaryImage& output) const {
+    if (input.height() > 0 && input.rowData(0) == output.row(0) && input.bitOffset() == 0 &&
+        input.width() == output.width() && input.height() == output.height()) {
+        applyInPlace(output);
+        return;
+    }
+    if (output.width() != input.width() || output.height() != input.height()) {
+        output = BinaryImage(input.width(), input.height(), false);
+    }
 
-    for (int y = 0; y < input.height(); ++y) {
-        for (int x = 0; x < input.width(); ++x) {
-            output.set(x, y, checkPixel(input, x, y));
+    if (iterations_ > 1 || !isSinglePass(operation_)) {
+        applyChained(input, output);
+    } else {
+        applyPass(input, operation_, output);
+    }
+}
+
+void Morphology::applyInPlace(BinaryImage& image) const {
+    int w = image.width();
+    int h = image.height();
+    if (w == 0 || h == 0) {
+        return;
+    }
+
+    int words = image.rowWords();
+    if (boundary_ == BoundaryMode::Wrap || !passesUseBitwise()) {
+        // Not chain_a: operations of several passes alternate through it
+        BinaryImage& result = scratch_.in_place;
+        apply(image, result);
+        for (int y = 0; y < h; ++y) {
+            std::copy(result.row(y), result.row(y) + words, image.row(y));
         }
+        return;
+    }
+
+    ChainPlan plan = chainPlan(operation_, iterations_);
+    std::vector<SeRow> se_rows = groupOffsetsByRow(se_.offsets);
+    int margin = horizontalReach(se_.offsets);
+    const ShapeRowKernels* fixed = fixedShapeKernel();
+    auto stream = [&](const std::vector<MorphOperation>& passes) {
+        return passes.empty() ? nullptr
+                              : std::make_unique<ChainStream>(image, passes, se_rows, fixed, margin,
+                                                              boundary_, 0, 0, 0, h);
+    };
+    std::unique_ptr<ChainStream> eroded = stream(plan.eroded);
+    std::unique_ptr<ChainStream> dilated = stream(plan.dilated);
+
+    // Finished rows wait here until both streams have copied the original
+    // row. Streams load ahead of the output row unless every SE offset
+    // points upwards, where they lag by at most passes * -dy_max rows.
+    int dy_max = se_rows.empty() ? 0 : se_rows.back().dy;
+    int passes = static_cast<int>(std::max(plan.eroded.size(), plan.dilated.size()));
+    int slots = passes * std::max(0, -dy_max) + 2;
+    int stride = alignedWords(words);
+    WordBuffer pending(static_cast<size_t>(slots) * stride);
+    auto pendingRow = [&](int y) { return pending.data() + static_cast<size_t>(y % slots) * stride; };
+    auto released = [&](int y) {
+        return (!eroded || eroded->released(y)) && (!dilated || dilated->released(y));
+    };
+
+    int flushed = 0;
+    for (int y = 0; y < h; ++y) {
+        writeOperationRow(plan.finish, image.row(y),
+                          eroded ? eroded->rowsFor(y).row(y) : nullptr,
+                          dilated ? dilated->rowsFor(y).row(y) : nullptr,
+                          pendingRow(y), words, image.rowTailMask());
+        for (; flushed <= y && released(flushed); ++flushed) {
+            rowKernels().copy(image.row(flushed), pendingRow(flushed), words);
+        }
+    }
+    for (; flushed < h; ++flushed) {
+        rowKernels().copy(image.row(flushed), pendingRow(flushed), words);
+    }
+}
+
+void Morphology::applyPass(const BinaryImageView& input, MorphOperation op, BinaryImage& output) const {
+    switch (engine_) {
+        case MorphEngine::PerPixel:
+            applyPerPixel(input, op, output);
+            break;
+
+        case MorphEngine::Bitwise:
+            applyBitwise(input, op, output);
+            break;
+
+        case MorphEngine::Lut: {
+            NeighborhoodLut lut;
+            if (makeLut(se_, op, lut)) {
+                applyTable(input, lut, output);
+            } else {
+                applyBitwise(input, op, output);
+            }
+            break;
+        }
+
+        case MorphEngine::Auto:
+            // Small fixed shapes are fastest as one unrolled bitwise pass
+            if (fixedShapeKernel()) {
+                applyBitwise(input, op, output);
+            } else {
+                applySeparable(input, op, output);
+            }
+            break;
+
+        case MorphEngine::Separable:
+        default:
+            // Falls back to the bitwise engine when the SE is not a rectangle
+            applySeparable(input, op, output);
+            break;
+    }
+}
+
+bool Morphology::passesUseBitwise() const {
+    SeRect rect;
+    NeighborhoodLut lut;
+    switch (engine_) {
+        case MorphEngine::PerPixel:
+            return false;
+        case MorphEngine::Bitwise:
+            return true;
+        case MorphEngine::Lut:
+            return !makeLut(se_, MorphOperation::Erosion, lut);
+        case MorphEngine::Auto:
+            return fixedShapeKernel() || !findRectangle(se_.offsets, rect);
+        default:
+            return !findRectangle(se_.offsets, rect);
+    }
+}
+
+void Morphology::applyChained(const BinaryImageView& input, BinaryImage& output) const {
+    int w = input.width();
+    int h = input.height();
+    if (w == 0 || h == 0) {
+        return;
+    }
+
+    ChainPlan plan = chainPlan(operation_, iterations_);
+    int words = input.rowWords();
+
+    if (boundary_ != BoundaryMode::Wrap && passesUseBitwise()) {
+        // Fused: each band streams its rows through every pass
+        std::vector<SeRow> se_rows = groupOffsetsByRow(se_.offsets);
+        int margin = horizontalReach(se_.offsets);
+        const ShapeRowKernels* fixed = fixedShapeKernel();
+        forEachBand(h, [&](int y0, int y1) {
+            auto stream = [&](const std::vector<MorphOperation>& passes) {
+                return passes.empty() ? nullptr
+                                      : std::make_unique<ChainStream>(input, passes, se_rows, fixed, margin,
+                                                                      boundary_, 0, 0, y0, y1);
+            };
+            std::unique_ptr<ChainStream> eroded = stream(plan.eroded);
+            std::unique_ptr<ChainStream> dilated = stream(plan.dilated);
+            WordBuffer original(words);
+            for (int y = y0; y < y1; ++y) {
+                writeOperationRow(plan.finish, input.alignedRow(y, original.data()),
+                                  eroded ? eroded->rowsFor(y).row(y) : nullptr,
+                                  dilated ? dilated->rowsFor(y).row(y) : nullptr,
+                                  output.row(y), words, input.rowTailMask());
+            }
+        });
+        return;
+    }
+
+    // One whole-image pass at a time, alternating between two scratch
+    // images. The gradient's dilation chain alternates between the free
+    // scratch image and the output, which its final XOR updates in place.
+    // Every pass overwrites all pixels, so kept images need no clearing.
+    BinaryImage& scratch_a = scratch_.chain_a;
+    BinaryImage& scratch_b = scratch_.chain_b;
+    for (BinaryImage* scratch : {&scratch_a, &scratch_b}) {
+        if (scratch->width() != w || scratch->height() != h) {
+            *scratch = BinaryImage(w, h, false);
+        }
+    }
+    auto run = [&](const std::vector<MorphOperation>& passes, BinaryImage* first,
+                   BinaryImage* second) -> const BinaryImage* {
+        const BinaryImage* src = nullptr;
+        BinaryImage* dst = first;
+        for (MorphOperation pass : passes) {
+            applyPass(src ? BinaryImageView(*src) : input, pass, *dst);
+            src = dst;
+            dst = dst == first ? second : first;
+        }
+        return src;
+    };
+    const BinaryImage* eroded = run(plan.eroded, &scratch_a, &scratch_b);
+    const BinaryImage* dilated = eroded ? run(plan.dilated, eroded == &scratch_a ? &scratch_b : &scratch_a, &output)
+                                        : run(plan.dilated, &scratch_a, &scratch_b);
+
+    forEachBand(h, [&](int y0, int y1) {
+        WordBuffer original(words);
+        for (int y = y0; y < y1; ++y) {
+            writeOperationRow(plan.finish, input.alignedRow(y, original.data()),
+                              eroded ? eroded->row(y) : nullptr,
+                              dilated ? dilated->row(y) : nullptr,
+                              output.row(y), words, input.rowTailMask());
+        }
+    });
+}
+
+void Morphology::setThreadCount(int threads) {
+    if (threads == 1) {
+        pool_.reset();
+    } else {
+        pool_ = std::make_shared<ThreadPool>(threads);
+    }
+}
+
+int Morphology::getThreadCount() const {
+    return pool_ ? pool_->threadCount() : 1;
+}
+
+int Morphology::bandCount(int rows) const {
+    if (!pool_ || pool_->threadCount() == 1) {
+        return 1;
+    }
+
+    // A few bands per thread so uneven bands still balance
+    constexpr int kMinBandRows = 8;
+    return std::max(1, std::min(pool_->threadCount() * 4, rows / kMinBandRows));
+}
+
+void Morphology::forEachBand(int rows, const std::function<void(int, int)>& body) const {
+    forEachIndexedBand(rows, [&](int, int y0, int y1) { body(y0, y1); });
+}
+
+void Morphology::forEachIndexedBand(int rows, const std::function<void(int, int, int)>& body) const {
+    int bands = bandCount(rows);
+    if (bands == 1) {
+        body(0, 0, rows);
+        return;
+    }
+
+    // Every band writes only its own output rows, and rows never share a
+    // word, so the result does not depend on scheduling
+    pool_->parallelFor(bands, [&](int band) {
+        int y0 = static_cast<int>(static_cast<int64_t>(rows) * band / bands);
+        int y1 = static_cast<int>(static_cast<int64_t>(rows) * (band + 1) / bands);
+        body(band, y0, y1);
+    });
+}
+
+void Morphology::applyPerPixel(const BinaryImageView& input, MorphOperation op, BinaryImage& output) const {
+    // Materialize the boundary once, O(perimeter), instead of per probe
+    int reach = 0;
+    for (const auto& [dx, dy] : se_.offsets) {
+        reach = std::max({reach, std::abs(dx), std::abs(dy)});
     }
+    BinaryImage padded = input.withBorder(reach);
+    padded.fillBorder(boundary_);
+
+    forEachBand(input.height(), [&](int y0, int y1) {
+        perPixelRows(padded, output, op, se_.offsets, y0, y1);
+    });
+}
 
+BinaryImage Morphology::applyLut(const BinaryImageView& input, const NeighborhoodLut& lut) const {
+    BinaryImage output(input.width(), input.height(), false);
+    applyTable(input, lut, output);
     return output;
 }
 
+void Morphology::applyTable(const BinaryImageView& input, const NeighborhoodLut& lut, BinaryImage& output) const {
+    if (input.width() == 0 || input.height() == 0) {
+        return;
+    }
+
+    BinaryImage padded = input.withBorder(1);
+    padded.fillBorder(boundary_);
+
+    forEachBand(input.height(), [&](int y0, int y1) {
+        for (int y = y0; y < y1; ++y) {
+            lutRow(padded, lut, y, output.row(y));
+        }
+    });
+}
+
+bool Morphology::makeLut(const StructuringElement& se, MorphOperation op, NeighborhoodLut& lut) {
+    for (const auto& [dx, dy] : se.offsets) {
+        if (dx < -1 || dx > 1 || dy < -1 || dy > 1) {
+            return false;
+        }
+    }
+
+    // Evaluate the operation on every possible neighborhood
+    for (unsigned index = 0; index < 512; ++index) {
+        auto probe = [index](int dx, int dy) { return ((index >> lutBit(dx, dy)) & 1) != 0; };
+        lut[index] = evaluatePixel(op, se.offsets, probe, 0, 0);
+    }
+    return true;
+}
+
+void Morphology::applyBitwise(const BinaryImageView& input, MorphOperation op, BinaryImage& output) const {
+    int w = input.width();
+    int h = input.height();
+    if (w == 0 || h == 0) {
+        return;
+    }
+
+    std::vector<SeRow> se_rows = groupOffsetsByRow(se_.offsets);
+    int margin = horizontalReach(se_.offsets);
+    bool need_erosion = needsErosion(op);
+    bool need_dilation = needsDilation(op);
+    int words = input.rowWords();
+    const ShapeRowKernels* fixed = fixedShapeKernel();
+
+    auto rowsInto = [&](const auto& src, int y, Word* eroded, Word* dilated, Word* original,
+                        std::vector<const Word*>& rows) {
+        erodeDilateRow(src, se_rows, fixed, rows, y, words, need_erosion, need_dilation, eroded, dilated);
+        writeOperationRow(op, input.alignedRow(y, original), eroded, dilated, output.row(y), words, input.rowTailMask());
+    };
+
+    if (boundary_ == BoundaryMode::Wrap) {
+        // Wrapped rows come from the far end of the image: pad all of it
+        PaddedRows padded(scratch_.padded, w, h, margin, boundary_);
+        forEachBand(h, [&](int y0, int y1) { padded.load(input, y0, y1); });
+        forEachBand(h, [&](int y0, int y1) {
+            WordBuffer eroded(words);
+            WordBuffer dilated(words);
+            WordBuffer original(words);
+            std::vector<const Word*> rows(fixed ? 2 * fixed->reach + 1 : 0);
+            for (int y = y0; y < y1; ++y) {
+                rowsInto(padded, y, eroded.data(), dilated.data(), original.data(), rows);
+            }
+        });
+        return;
+    }
+
+    // Large uniform regions resolve from the tile map alone, so only the
+    // words near an edge run the kernels
+    const TileMap* tiles = nullptr;
+    if (!se_.offsets.empty()) {
+        scratch_.tiles.assign(input);
+        if (scratch_.tiles.uniformCount() > 0) {
+            tiles = &scratch_.tiles;
+        }
+    }
+
+    // Each band copies only the SE-height window of input rows it reads
+    int dy_min = se_rows.empty() ? 0 : se_rows.front().dy;
+    int dy_max = se_rows.empty() ? 0 : se_rows.back().dy;
+    const std::vector<MorphOperation> no_passes;
+    forEachBand(h, [&](int y0, int y1) {
+        ChainStream window(input, no_passes, se_rows, fixed, margin, boundary_, dy_min, dy_max, y0, y1);
+        WordBuffer eroded(words);
+        WordBuffer dilated(words);
+        WordBuffer original(words);
+        std::vector<const Word*> rows(fixed ? 2 * fixed->reach + 1 : 0);
+        if (!tiles) {
+            for (int y = y0; y < y1; ++y) {
+                rowsInto(window.rowsFor(y), y, eroded.data(), dilated.data(), original.data(), rows);
+            }
+            return;
+        }
+
+        TileSkip skip(*tiles, w, h, boundary_, se_.offsets);
+        for (int y = y0; y < y1; ++y) {
+            const RingRows& src = window.rowsFor(y);
+            for (const WordRun& run : skip.runs(y)) {
+                int count = run.end - run.begin;
+                if (run.state == TileState::Mixed) {
+                    erodeDilateRow(OffsetRows<RingRows>{src, run.begin}, se_rows, fixed, rows, y, count,
+                                   need_erosion, need_dilation, eroded.data() + run.begin,
+                                   dilated.data() + run.begin);
+                } else {
+                    Word value = run.state == TileState::Full ? ~Word(0) : 0;
+                    if (need_erosion) {
+                        rowKernels().fill(eroded.data() + run.begin, value, count);
+                    }
+                    if (need_dilation) {
+                        rowKernels().fill(dilated.data() + run.begin, value, count);
+                    }
+                }
+            }
+            writeOperationRow(op, input.alignedRow(y, original.data()), eroded.data(), dilated.data(),
+                              output.row(y), words, input.rowTailMask());
+        }
+    });
+}
+
+void Morphology::applySeparable(const BinaryImageView& input, MorphOperation op, BinaryImage& output) const {
+    SeRect rect;
+    if (!findRectangle(se_.offsets, rect)) {
+        applyBitwise(input, op, output);
+        return;
+    }
+
+    int w = input.width();
+    int h = input.height();
+    if (w == 0 || h == 0) {
+        return;
+    }
+
+    // Rectangle = horizontal segment followed by vertical segment
+    std::vector<SeRow> horizontal(1, SeRow{0, {}});
+    for (int dx = rect.x0; dx <= rect.x1; ++dx) {
+        horizontal[0].dxs.push_back(dx);
+    }
+    std::vector<SeRow> vertical;
+    for (int dy = rect.y0; dy <= rect.y1; ++dy) {
+        vertical.push_back({dy, {0}});
+    }
+
+    PaddedRows padded(scratch_.padded, w, h, std::max(std::abs(rect.x0), std::abs(rect.x1)), boundary_);
+    forEachBand(h, [&](int y0, int y1) { padded.load(input, y0, y1); });
+
+    bool need_erosion = needsErosion(op);
+    bool need_dilation = needsDilation(op);
+
+    // Horizontal pass into scratch rows. The vertical pass reads them with
+    // the same boundary mode, which is exact for every mode: an out-of-range
+    // row of the intermediate equals the horizontal pass of the constant,
+    // clamped or wrapped source row.
+    int words = input.rowWords();
+    int seg_width = rect.x1 - rect.x0 + 1;
+    int seg_height = rect.y1 - rect.y0 + 1;
+    PaddedRows eroded_h(scratch_.eroded_h, w, need_erosion ? h : 0, 0, boundary_);
+    PaddedRows dilated_h(scratch_.dilated_h, w, need_dilation ? h : 0, 0, boundary_);
+    forEachBand(h, [&](int y0, int y1) {
+        WordBuffer line_a;
+        WordBuffer line_b;
+        for (int y = y0; y < y1; ++y) {
+            for (int pass = 0; pass < 2; ++pass) {
+                bool erode = pass == 0;
+                if (erode ? !need_erosion : !need_dilation) {
+                    continue;
+                }
+                Word* dst = erode ? eroded_h.mutableRow(y) : dilated_h.mutableRow(y);
+                if (seg_width >= kLineKernelMinLength) {
+                    horizontalLine(padded, y, rect.x0, seg_width, words, erode, dst, line_a, line_b);
+                } else {
+                    accumulateRow(padded, horizontal, y, words, erode, dst);
+                }
+            }
+        }
+    });
+
+    // Vertical pass: each band reads the scratch rows of its halo, which
+    // the previous pass completed for every band
+    int v_stride = alignedWords(words);
+    WordBuffer& eroded_v = scratch_.eroded_v;
+    WordBuffer& dilated_v = scratch_.dilated_v;
+    eroded_v.resize(need_erosion ? static_cast<size_t>(h) * v_stride : 0);
+    dilated_v.resize(need_dilation ? static_cast<size_t>(h) * v_stride : 0);
+
+    // One slice of Van Herk scratch per band, sized for the tallest band
+    bool van_herk = seg_height >= kLineKernelMinLength;
+    int bands = bandCount(h);
+    size_t slice = vanHerkScratchWords((h + bands - 1) / bands, seg_height, words);
+    if (van_herk) {
+        scratch_.van_herk.resize(slice * bands);
+    }
+    forEachIndexedBand(h, [&](int band, int y0, int y1) {
+        if (van_herk) {
+            Word* band_scratch = scratch_.van_herk.data() + slice * band;
+            if (need_erosion) {
+                vanHerkVertical(eroded_h, y0, y1, rect.y0, seg_height, words, true, eroded_v.data(), v_stride,
+                                band_scratch);
+            }
+            if (need_dilation) {
+                vanHerkVertical(dilated_h, y0, y1, rect.y0, seg_height, words, false, dilated_v.data(), v_stride,
+                                band_scratch);
+            }
+        } else {
+            for (int y = y0; y < y1; ++y) {
+                size_t offset = static_cast<size_t>(y) * v_stride;
+                if (need_erosion) {
+                    accumulateRow(eroded_h, vertical, y, words, true, &eroded_v[offset]);
+                }
+                if (need_dilation) {
+                    accumulateRow(dilated_h, vertical, y, words, false, &dilated_v[offset]);
+                }
+            }
+        }
+
+        WordBuffer original(words);
+        for (int y = y0; y < y1; ++y) {
+            size_t offset = static_cast<size_t>(y) * v_stride;
+            writeOperationRow(op, input.alignedRow(y, original.data()),
+                              need_erosion ? &eroded_v[offset] : nullptr,
+                              need_dilation ? &dilated_v[offset] : nullptr,
+                              output.row(y), words, input.rowTailMask());
+        }
+    });
+}
+
 std::vector<std::pair<int, int>> Morphology::getCoveredPositions(int x, int y) const {
     std::vector<std::pair<int, int>> positions;
     positions.reserve(se_.offsets.size());
@@ -153,3 +1587,43 @@ std::vector<std::pair<int, int>> Morphology::getCoveredPositions(int x, int y) c
 
     return positions;
 }
+
+MorphologyStepper::MorphologyStepper(const Morphology& morph, const BinaryImageView& input,
+                                     BinaryImage& output)
+    : morph_(morph)
+    , input_(input)
+    , output_(output)
+{
+}
+
+void MorphologyStepper::reset() {
+    x_ = 0;
+    y_ = 0;
+}
+
+bool MorphologyStepper::step() {
+    if (isComplete()) {
+        return false;
+    }
+
+    output_.set(x_, y_, morph_.checkPixel(input_, x_, y_));
+    if (++x_ >= input_.width()) {
+        x_ = 0;
+        ++y_;
+    }
+    return !isComplete();
+}
+
+size_t MorphologyStepper::step(size_t count) {
+    for (size_t taken = 0; taken < count; ++taken) {
+        if (isComplete()) {
+            return taken;
+        }
+        step();
+    }
+    return count;
+}
+
+size_t MorphologyStepper::stepFor(int64_t microseconds) {
+    return runForBudget(microseconds, [this](size_t count) { return step(count); });
+}
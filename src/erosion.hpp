@@ -2,18 +2,16 @@
 #define MORPHOLOGY_HPP
 
 #include "binary_image.hpp"
+#include "thread_pool.hpp"
+#include "tile_map.hpp"
+#include <bitset>
+#include <cstdint>
+#include <functional>
+#include <memory>
 #include <vector>
 #include <utility>
 
-/**
- * @brief Boundary handling modes for morphological operations.
- */
-enum class BoundaryMode {
-    Zero,      ///< Out-of-bounds pixels are treated as 0 (background)
-    One,       ///< Out-of-bounds pixels are treated as 1 (foreground)
-    Extend,    ///< Extend edge pixels (clamp to nearest border pixel)
-    Wrap       ///< Wrap around to opposite edge (periodic boundary)
-};
+struct ShapeRowKernels;
 
 /**
  * @brief Type of morphological operation.
@@ -23,9 +21,32 @@ enum class MorphOperation {
     Dilation,       ///< Expands foreground (output=1 if ANY neighbor is 1)
     InnerBoundary,  ///< Internal edge: Original - Eroded (contour inside shape)
     OuterBoundary,  ///< External edge: Dilated - Original (contour outside shape)
-    Gradient        ///< Morphological gradient: Dilated - Eroded (full edge)
+    Gradient,       ///< Morphological gradient: Dilated - Eroded (full edge)
+    Opening,        ///< Erosion then dilation: removes specks smaller than the SE
+    Closing,        ///< Dilation then erosion: fills holes smaller than the SE
+    WhiteTopHat,    ///< Original - Opening (bright detail smaller than the SE)
+    BlackTopHat     ///< Closing - Original (holes and gaps smaller than the SE)
+};
+
+/**
+ * @brief Implementation strategy used by Morphology::apply.
+ */
+enum class MorphEngine {
+    Auto,      ///< Pick the fastest engine that supports the structuring element
+    PerPixel,  ///< Probe every SE offset for every pixel (reference implementation)
+    Bitwise,   ///< Shift-and-AND/OR over bit-packed 64-pixel words, unrolled for fixed shapes
+    Separable, ///< Horizontal then vertical 1-D pass for rectangular SEs
+    Lut        ///< 512-entry table lookup per pixel for SEs within 3x3
 };
 
+/**
+ * @brief Output table of a 3x3 neighborhood operator.
+ *
+ * Entry i is the output for the neighborhood whose pixel at offset
+ * (dx, dy) is bit Morphology::lutBit(dx, dy) of i.
+ */
+using NeighborhoodLut = std::bitset<512>;
+
 /**
  * @brief Represents a structuring element for morphological operations.
  */
@@ -38,6 +59,7 @@ struct StructuringElement {
 
     static StructuringElement createSquare(int size);
     static StructuringElement createCross(int size);
+    static StructuringElement createDisk(int radius);
 };
 
 /**
@@ -49,6 +71,11 @@ struct StructuringElement {
  * - Inner Boundary: Original - Eroded (internal contour)
  * - Outer Boundary: Dilated - Original (external contour)
  * - Gradient: Dilated - Eroded (full edge/thickness)
+ * - Opening / Closing: Erosion then dilation, or the reverse
+ * - White / Black Top-Hat: Original - Opening, Closing - Original
+ *
+ * With setIterations(n) every erosion and dilation is repeated n times,
+ * e.g. opening erodes n times and then dilates n times.
  */
 class Morphology {
 public:
@@ -58,21 +85,101 @@ public:
 
     /**
      * @brief Perform the morphological operation on entire image.
+     *
+     * Every engine produces exactly the same result as calling
+     * checkPixel() for each pixel, serial or parallel.
+     *
+     * Operations made of several passes behave as if each pass were applied
+     * to the previous result with the same boundary mode. They alternate
+     * between two scratch images kept by this object, see
+     * apply(input, output); with the bitwise engine and a boundary
+     * other than Wrap the passes are instead fused row by row, so the rows
+     * between passes stay in cache.
+     *
+     * The single-pass bitwise engine summarizes the input in 64x64 tiles
+     * (TileMap) and fills long stretches of words whose whole footprint is
+     * one uniform value without running the kernels.
+     *
+     * The input may be a view of a rectangle of a larger image, e.g.
+     * BinaryImage::view(); its pixels are read in place and the boundary
+     * mode applies at the edges of the view.
+     */
+    BinaryImage apply(const BinaryImageView& input) const;
+
+    /**
+     * @brief Same as apply(input), writing into a caller-owned image.
+     * @param input Source image
+     * @param output Receives the result. Its storage is reused when the
+     *        size matches, otherwise it is replaced by a new image. Every
+     *        pixel is overwritten, so it needs no clearing. Passing the
+     *        input image itself is the same as applyInPlace(); otherwise it
+     *        must not share pixels with the input.
+     *
+     * Whole-image scratch is kept in this object and reused by later calls
+     * while the input size stays the same: the two images between the
+     * passes of an operation made of several passes, the padded copy, the
+     * two intermediate passes and the vertical segment buffers of the
+     * separable engine, the padded copy of the bitwise engine with Wrap,
+     * and the tile map of the bitwise engine. Apart from those, the
+     * bitwise and separable engines allocate only a few rows per band,
+     * while the per-pixel and table engines also copy the input with a
+     * border on every call.
+     * Because of the kept scratch, one object must not run apply() on
+     * several threads at once; give each thread its own copy.
+     */
+    void apply(const BinaryImageView& input, BinaryImage& output) const;
+
+    /**
+     * @brief Replace an image by the result of the operation.
+     *
+     * With the bitwise engine and a boundary other than Wrap, the rows are
+     * streamed through a few row buffers and each row is written back once
+     * no later row reads its original value; this runs on one thread. Other
+     * engines and Wrap, which reads the bottom rows for the first ones,
+     * compute into an image kept by this object first and copy it back.
      */
-    BinaryImage apply(const BinaryImage& input) const;
+    void applyInPlace(BinaryImage& image) const;
 
     /**
      * @brief Check result for a single pixel (for animated step-by-step).
      * 
      * Note: For boundary operations, this computes the result by
      * checking erosion/dilation of the pixel and comparing with original.
+     * The gradient takes both from a single walk over the footprint.
+     */
+    bool checkPixel(const BinaryImageView& input, int x, int y) const;
+
+    /**
+     * @brief Apply an arbitrary 3x3 neighborhood operator.
+     * @param input Source image, read with this object's boundary mode
+     * @param lut Output for every 9-pixel neighborhood
+     *
+     * The neighborhood index is updated as a sliding window, one 3-pixel
+     * column per step, so each pixel costs one table lookup. The SE and
+     * operation of this object are not used.
      */
-    bool checkPixel(const BinaryImage& input, int x, int y) const;
+    BinaryImage applyLut(const BinaryImageView& input, const NeighborhoodLut& lut) const;
+
+    /**
+     * @brief Build the table of a MorphOperation with an SE within 3x3.
+     * @param se Structuring element, every offset in [-1, 1]
+     * @param op Operation the table reproduces
+     * @param lut Receives the table
+     * @return false if the SE does not fit in 3x3 (lut is left unchanged)
+     */
+    static bool makeLut(const StructuringElement& se, MorphOperation op, NeighborhoodLut& lut);
+
+    /**
+     * @brief Bit of a NeighborhoodLut index holding the pixel at (dx, dy).
+     *
+     * Columns enter the window from the right, so dx = 1 is in bits 0-2.
+     */
+    static constexpr int lutBit(int dx, int dy) { return (1 - dx) * 3 + (dy + 1); }
 
     /**
      * @brief Get pixel value with boundary handling.
      */
-    bool getPixelWithBoundary(const BinaryImage& input, int x, int y) const;
+    bool getPixelWithBoundary(const BinaryImageView& input, int x, int y) const;
 
     /**
      * @brief Get positions covered by SE at given location.
@@ -83,21 +190,143 @@ public:
     const StructuringElement& getStructuringElement() const { return se_; }
     MorphOperation getOperation() const { return operation_; }
     BoundaryMode getBoundaryMode() const { return boundary_; }
+    MorphEngine getEngine() const { return engine_; }
+    int getIterations() const { return iterations_; }
 
     // Setters
     void setOperation(MorphOperation op) { operation_ = op; }
     void setBoundaryMode(BoundaryMode mode) { boundary_ = mode; }
+    void setEngine(MorphEngine engine) { engine_ = engine; }
+
+    /**
+     * @brief Repeat every erosion and dilation of the operation.
+     * @param iterations Number of repetitions, at least 1
+     */
+    void setIterations(int iterations) { iterations_ = iterations < 1 ? 1 : iterations; }
+
+    /**
+     * @brief Run apply() on a pool of threads over bands of output rows.
+     * @param threads Total threads (1: serial, <= 0: one per hardware thread)
+     *
+     * Copies of this object share the pool. The output is bit-identical to
+     * the serial result for any thread count.
+     */
+    void setThreadCount(int threads);
+    int getThreadCount() const;
 
 private:
     // Helper functions for erosion/dilation at a single pixel
-    bool checkErosion(const BinaryImage& input, int x, int y) const;
-    bool checkDilation(const BinaryImage& input, int x, int y) const;
+    bool checkErosion(const BinaryImageView& input, int x, int y) const;
+    bool checkDilation(const BinaryImageView& input, int x, int y) const;
+    bool checkGradient(const BinaryImageView& input, int x, int y) const;
+
+    // Result of a pixel for operations made of several passes
+    bool checkChained(const BinaryImageView& input, int x, int y) const;
+
+    // Whole-image engines, writing every row of an output of the input size
+    void applyPass(const BinaryImageView& input, MorphOperation op, BinaryImage& output) const;
+    void applyPerPixel(const BinaryImageView& input, MorphOperation op, BinaryImage& output) const;
+    void applyBitwise(const BinaryImageView& input, MorphOperation op, BinaryImage& output) const;
+    void applySeparable(const BinaryImageView& input, MorphOperation op, BinaryImage& output) const;
+    void applyTable(const BinaryImageView& input, const NeighborhoodLut& lut, BinaryImage& output) const;
+
+    // Operations of several passes, see apply()
+    void applyChained(const BinaryImageView& input, BinaryImage& output) const;
+    bool passesUseBitwise() const;
+
+    // Run body(y0, y1) over bands covering [0, rows), in parallel if enabled
+    void forEachBand(int rows, const std::function<void(int, int)>& body) const;
+    // Same, as body(band, y0, y1) with band in [0, bandCount(rows))
+    void forEachIndexedBand(int rows, const std::function<void(int, int, int)>& body) const;
+    int bandCount(int rows) const;
+
+    // Unrolled kernels of se_ for the active instruction set, or nullptr
+    const ShapeRowKernels* fixedShapeKernel() const;
 
     StructuringElement se_;
     MorphOperation operation_;
     BoundaryMode boundary_;
+    MorphEngine engine_ = MorphEngine::Auto;
+    int iterations_ = 1;
+    // Whole-image buffers kept between apply() calls, reused while the
+    // size matches. A copy starts without any, so objects never share them.
+    struct Scratch {
+        using Buffer = std::vector<BinaryImage::Word,
+                                   AlignedAllocator<BinaryImage::Word, BinaryImage::kRowAlignment>>;
+        Buffer padded;     // Input with horizontal margins
+        Buffer eroded_h;   // Horizontal passes of the separable engine
+        Buffer dilated_h;
+        Buffer eroded_v;   // Vertical passes of the separable engine
+        Buffer dilated_v;
+        Buffer van_herk;   // Per-band block suffixes and prefix of long vertical segments
+        BinaryImage chain_a = BinaryImage(0, 0);  // Images between passes of applyChained()
+        BinaryImage chain_b = BinaryImage(0, 0);
+        BinaryImage in_place = BinaryImage(0, 0);  // Result of applyInPlace() before the copy back
+        TileMap tiles;
+
+        Scratch() = default;
+        Scratch(const Scratch&) {}
+        Scratch& operator=(const Scratch&) { return *this; }
+    };
+
+    int fixed_shape_ = -1;  // FixedShape of se_, matched once; -1 if none
+    std::shared_ptr<ThreadPool> pool_;
+    mutable Scratch scratch_;
 };
 
 using Erosion = Morphology;
 
+/**
+ * @brief Computes a Morphology result one pixel at a time, for animation.
+ *
+ * Pixels are visited in raster order and each one is set from
+ * checkPixel(), so every pixel before the current position already holds
+ * its apply() value. The operation, input and output are referenced, not
+ * copied, and must outlive the stepper.
+ */
+class MorphologyStepper {
+public:
+    /**
+     * @brief Start at pixel (0, 0).
+     * @param morph Operation to compute
+     * @param input Source image or view
+     * @param output Result, same size as the input
+     */
+    MorphologyStepper(const Morphology& morph, const BinaryImageView& input, BinaryImage& output);
+
+    /**
+     * @brief Go back to pixel (0, 0). The output is left as it is.
+     */
+    void reset();
+
+    /**
+     * @brief Compute the current pixel and move to the next.
+     * @return false once every pixel is computed
+     */
+    bool step();
+
+    /**
+     * @brief Compute up to count pixels.
+     * @return Pixels computed, fewer than count only at the end
+     */
+    size_t step(size_t count);
+
+    /**
+     * @brief Compute pixels until done or about microseconds have passed.
+     * @return Pixels computed, at least one unless already complete
+     */
+    size_t stepFor(int64_t microseconds);
+
+    bool isComplete() const { return y_ >= input_.height() || input_.width() == 0; }
+    int currentX() const { return x_; }
+    int currentY() const { return y_; }
+
+private:
+    const Morphology& morph_;
+    BinaryImageView input_;
+    BinaryImage& output_;
+    int x_ = 0;
+    int y_ = 0;
+};
+
 #endif // MORPHOLOGY_HPP
@@ -0,0 +1,86 @@
+#include "fill_index.hpp"
+#include "distance_transform.hpp"
+#include <algorithm>
+
+FillIndex::FillIndex(const BinaryImageView& image, Connectivity connectivity, int safety_radius)
+    : connectivity_(connectivity)
+    , safety_radius_(std::max(0, safety_radius))
+    , width_(image.width())
+    , height_(image.height())
+{
+    BinaryImage source(image);
+    for (int v = 0; v < 2; ++v) {
+        bool value = v == 1;
+        ComponentLabels& labels = labels_[v];
+        if (safety_radius_ == 0) {
+            labels.relabel(source, connectivity_, value);
+        } else {
+            // Same safe set as FloodFill: the nearest pixel of the other
+            // value, outside the image included, is farther than the radius
+            int64_t r = safety_radius_;
+            BinaryImage safe = DistanceField::compute(
+                source, value ? BoundaryMode::Zero : BoundaryMode::One, !value)
+                .farther(static_cast<uint64_t>(r * r));
+            labels.relabel(safe, connectivity_, true);
+        }
+
+        // Spans grouped by label, raster order within each label
+        std::vector<size_t>& start = span_start_[v];
+        start.assign(labels.count() + 1, 0);
+        for (int pass = 0; pass < 2; ++pass) {
+            std::vector<size_t> next(start.begin(), start.end() - 1);
+            for (int y = 0; y < height_; ++y) {
+                const int32_t* row = labels.row(y);
+                for (int x = 0; x < width_;) {
+                    int32_t label = row[x];
+                    int x0 = x;
+                    while (x < width_ && row[x] == label) {
+                        ++x;
+                    }
+                    if (label == 0) {
+                        continue;
+                    }
+                    if (pass == 0) {
+                        ++start[label];
+                    } else {
+                        spans_[v][next[label - 1]++] = {y, x0, x};
+                    }
+                }
+            }
+            if (pass == 0) {
+                for (size_t l = 1; l < start.size(); ++l) {
+                    start[l] += start[l - 1];
+                }
+                spans_[v].resize(start.back());
+            }
+        }
+    }
+}
+
+FillRegion FillIndex::query(int x, int y) const {
+    FillRegion region;
+    for (int v = 0; v < 2; ++v) {
+        int32_t label = labels_[v].get(x, y);
+        if (label == 0) {
+            continue;
+        }
+        region.label = label;
+        region.value = v == 1;
+        region.stats = labels_[v].stats()[label - 1];
+        region.spans = spans_[v].data() + span_start_[v][label - 1];
+        region.span_count = span_start_[v][label] - span_start_[v][label - 1];
+        break;
+    }
+    return region;
+}
+
+BinaryImage FillIndex::mask(const FillRegion& region) const {
+    BinaryImage result(width_, height_, false);
+    for (size_t i = 0; i < region.span_count; ++i) {
+        const FillSpan& span = region.spans[i];
+        for (int x = span.x0; x < span.x1; ++x) {
+            result.set(x, span.y, true);
+        }
+    }
+    return result;
+}
@@ -0,0 +1,85 @@
+#ifndef FILL_INDEX_HPP
+#define FILL_INDEX_HPP
+
+#include "binary_image.hpp"
+#include "connected_components.hpp"
+#include <cstdint>
+#include <vector>
+
+/**
+ * @brief Horizontal run [x0, x1) of row y.
+ */
+struct FillSpan {
+    int y;
+    int x0;
+    int x1;
+};
+
+/**
+ * @brief Pixels a flood fill from one seed reaches.
+ */
+struct FillRegion {
+    int32_t label = 0;            ///< Component label, 0 if the fill reaches nothing
+    bool value = false;           ///< Pixel value the region covers
+    ComponentStats stats;         ///< Area, bounding box and centroid
+    const FillSpan* spans = nullptr;  ///< Raster-ordered runs, owned by the index
+    size_t span_count = 0;
+};
+
+/**
+ * @brief Answers flood-fill queries on one image without traversing it.
+ *
+ * A FloodFill from a seed fills the component of the seed among the safe
+ * pixels of the seed's value, i.e. the pixels of that value where the
+ * safety disk fits. The index labels the safe pixels of both values once
+ * and keeps the runs of every component, so each query is a label lookup.
+ *
+ * The index is tied to the image, connectivity and safety radius it was
+ * built with; build a new one when any of them changes.
+ */
+class FillIndex {
+public:
+    /**
+     * @brief Build the index.
+     * @param image Image to fill, read only during construction
+     * @param connectivity Neighbors the fill spreads to
+     * @param safety_radius Radius of the disk that must fit, 0 for none
+     */
+    FillIndex(const BinaryImageView& image,
+              Connectivity connectivity = Connectivity::Four,
+              int safety_radius = 0);
+
+    /**
+     * @brief Region a completed FloodFill from (x, y) would cover.
+     * @return Region with label 0 and no spans if the seed is outside the
+     *         image or not safe
+     */
+    FillRegion query(int x, int y) const;
+
+    /**
+     * @brief Pixels of a region as an image of the indexed size.
+     */
+    BinaryImage mask(const FillRegion& region) const;
+
+    /**
+     * @brief Labels of the safe pixels of one value.
+     */
+    const ComponentLabels& labels(bool value) const { return labels_[value ? 1 : 0]; }
+
+    Connectivity getConnectivity() const { return connectivity_; }
+    int getSafetyRadius() const { return safety_radius_; }
+
+private:
+    Connectivity connectivity_;
+    int safety_radius_;
+    int width_;
+    int height_;
+
+    // Per value: labels, and the spans of label l at
+    // spans_[span_start_[l - 1]] up to spans_[span_start_[l]]
+    ComponentLabels labels_[2];
+    std::vector<FillSpan> spans_[2];
+    std::vector<size_t> span_start_[2];
+};
+
+#endif // FILL_INDEX_HPP
@@ -1,4 +1,5 @@
 #include "floodfill.hpp"
+#include "step_budget.hpp"
 #include <algorithm>
 #include <cmath>
 
@@ -27,6 +28,32 @@ void FloodFill::updateOffsets() {
         offsets_.push_back({-1, 1});
         offsets_.push_back({1, 1});
     }
+    
+    updateNeighborDeltas();
+}
+
+void FloodFill::setAlgorithm(FillAlgorithm a) {
+    // Scanline queues one seed per run of InQueue pixels, and seeds may be
+    // stale. The pixel-wise algorithms expand only what is in the frontier,
+    // so they get one entry per InQueue pixel instead.
+    if (algorithm_ == FillAlgorithm::Scanline && a != FillAlgorithm::Scanline && initialized_) {
+        frontier_.clear();
+        for (int y = 0; y < height_; ++y) {
+            for (int x = 0; x < width_; ++x) {
+                if (state_[stateIndex(x, y)] == PixelState::InQueue) {
+                    frontier_.push_back({x, y});
+                }
+            }
+        }
+    }
+    algorithm_ = a;
+}
+
+void FloodFill::updateNeighborDeltas() {
+    neighbor_deltas_.clear();
+    for (const auto& [dx, dy] : offsets_) {
+        neighbor_deltas_.push_back(static_cast<std::ptrdiff_t>(dy) * state_stride_ + dx);
+    }
 }
 
 void FloodFill::updateDiskOffsets() {
@@ -90,44 +117,110 @@ std::vector<std::pair<int, int>> FloodFill::getCirclePositions(int center_x, int
 }
 
 void FloodFill::precomputeSafetyMask() {
-    safety_mask_ = BinaryImage(width_, height_, false);
-    
     if (safety_radius_ <= 0) {
         // No safety radius - all target_value pixels are safe
+        safety_mask_ = BinaryImage(width_, height_, false);
         for (int y = 0; y < height_; ++y) {
-            for (int x = 0; x < width_; ++x) {
-                if (source_.get(x, y) == target_value_) {
-                    safety_mask_.set(x, y, true);
-                }
+            const BinaryImage::Word* src = source_.row(y);
+            BinaryImage::Word* dst = safety_mask_.row(y);
+            for (int i = 0; i < source_.rowWords(); ++i) {
+                dst[i] = target_value_ ? src[i] : ~src[i];
             }
+            dst[source_.rowWords() - 1] &= source_.rowTailMask();
         }
-    } else {
-        // Check each pixel to see if the circle fits
-        for (int y = 0; y < height_; ++y) {
-            for (int x = 0; x < width_; ++x) {
-                // Only check pixels that are the target value
-                if (source_.get(x, y) == target_value_) {
-                    if (checkCircleFits(x, y)) {
-                        safety_mask_.set(x, y, true);
-                    }
+        return;
+    }
+
+    // The disk fits iff the nearest non-target pixel is farther than the
+    // radius. Cost is independent of the radius. A tile of non-target
+    // pixels is unsafe throughout, and a tile whose disk halo is all target
+    // pixels inside the image is safe throughout; only the other tiles
+    // read the clearance field.
+    int64_t r = safety_radius_;
+    uint64_t limit = static_cast<uint64_t>(r * r);
+    TileState target = target_value_ ? TileState::Full : TileState::Empty;
+    int tile = TileMap::kTileSize;
+    int reach = static_cast<int>((r + tile - 1) / tile);
+    safety_mask_ = BinaryImage(width_, height_, false);
+    const DistanceField* field = nullptr;
+    for (int ty = 0; ty < tiles_.tilesY(); ++ty) {
+        int y_end = std::min(height_, (ty + 1) * tile);
+        for (int tx = 0; tx < tiles_.tilesX(); ++tx) {
+            TileState state = tiles_.state(tx, ty);
+            if (state != TileState::Mixed && state != target) {
+                continue;
+            }
+            bool halo_inside = tx * tile - r >= 0 && (tx + 1) * tile - 1 + r < width_ &&
+                               ty * tile - r >= 0 && y_end - 1 + r < height_;
+            if (state == target && halo_inside &&
+                tiles_.blockState(tx - reach, ty - reach, tx + reach, ty + reach) == target) {
+                for (int y = ty * tile; y < y_end; ++y) {
+                    safety_mask_.row(y)[tx] = ~BinaryImage::Word(0);
                 }
+                continue;
+            }
+
+            if (!field) {
+                field = &clearanceField();
+            }
+            int x_end = std::min(width_, (tx + 1) * tile);
+            for (int y = ty * tile; y < y_end; ++y) {
+                const uint32_t* values = field->row(y);
+                BinaryImage::Word bits = 0;
+                for (int x = tx * tile; x < x_end; ++x) {
+                    bits |= BinaryImage::Word(values[x] > limit) << (x - tx * tile);
+                }
+                safety_mask_.row(y)[tx] = bits;
             }
         }
     }
 }
 
-void FloodFill::initialize(const BinaryImage& image, int start_x, int start_y) {
+const DistanceField& FloodFill::clearanceField() {
+    int index = target_value_ ? 1 : 0;
+    if (!clearance_valid_[index]) {
+        // Pixels outside the image count as non-target, so the outside
+        // must hold the non-target value: Zero for a foreground fill, One
+        // for a background fill.
+        clearance_[index] = DistanceField::compute(
+            source_,
+            target_value_ ? BoundaryMode::Zero : BoundaryMode::One,
+            !target_value_);
+        clearance_valid_[index] = true;
+    }
+    return clearance_[index];
+}
+
+void FloodFill::initialize(const BinaryImageView& image, int start_x, int start_y) {
     width_ = image.width();
     height_ = image.height();
-    source_ = image;
-    result_ = BinaryImage(width_, height_, false);
+    if (source_ != image) {
+        source_.assign(image);
+        clearance_valid_[0] = false;
+        clearance_valid_[1] = false;
+        tiles_ = TileMap(source_);
+    }
+    if (result_.width() == width_ && result_.height() == height_) {
+        result_.clear();
+    } else {
+        result_ = BinaryImage(width_, height_, false);
+    }
     
-    // Initialize state grid
-    state_.clear();
-    state_.resize(height_, std::vector<PixelState>(width_, PixelState::Unvisited));
+    // Initialize state grid in place. The one-pixel guard ring reads as
+    // Boundary, so neighbor checks never need a bounds test.
+    state_stride_ = width_ + 2;
+    state_.assign(static_cast<size_t>(state_stride_) * (height_ + 2), PixelState::Unvisited);
+    std::fill(state_.begin(), state_.begin() + state_stride_, PixelState::Boundary);
+    std::fill(state_.end() - state_stride_, state_.end(), PixelState::Boundary);
+    for (int y = 0; y < height_; ++y) {
+        state_[stateIndex(-1, y)] = PixelState::Boundary;
+        state_[stateIndex(width_, y)] = PixelState::Boundary;
+    }
+    updateNeighborDeltas();
     
     // Clear frontier
     frontier_.clear();
+    visited_.valid = false;
     filled_count_ = 0;
     unsafe_count_ = 0;
     current_pixel_ = {-1, -1};
@@ -147,7 +240,7 @@ void FloodFill::initialize(const BinaryImage& image, int start_x, int start_y) {
     // Check if starting position is safe
     if (!safety_mask_.get(start_x, start_y)) {
         // Starting position is not safe - mark but don't add to frontier
-        state_[start_y][start_x] = PixelState::Unsafe;
+        state_[stateIndex(start_x, start_y)] = PixelState::Unsafe;
         unsafe_count_++;
         initialized_ = true;
         return;
@@ -155,7 +248,7 @@ void FloodFill::initialize(const BinaryImage& image, int start_x, int start_y) {
     
     // Add starting pixel to frontier
     frontier_.push_back({start_x, start_y});
-    state_[start_y][start_x] = PixelState::InQueue;
+    state_[stateIndex(start_x, start_y)] = PixelState::InQueue;
     
     initialized_ = true;
 }
@@ -165,6 +258,15 @@ bool FloodFill::step() {
         return false;
     }
     
+    if (algorithm_ == FillAlgorithm::ParallelBFS) {
+        return stepLevel();
+    }
+    visited_.valid = false;
+    
+    if (algorithm_ == FillAlgorithm::Scanline) {
+        return stepScanline();
+    }
+    
     // Get next pixel based on algorithm
     std::pair<int, int> pixel;
     if (algorithm_ == FillAlgorithm::BFS) {
@@ -180,52 +282,242 @@ bool FloodFill::step() {
     current_pixel_ = pixel;
     
     // Mark as processed and fill
-    state_[y][x] = PixelState::Processed;
+    size_t index = stateIndex(x, y);
+    state_[index] = PixelState::Processed;
     result_.set(x, y, true);
     filled_count_++;
     
     // Check all neighbors
-    for (const auto& [dx, dy] : offsets_) {
-        int nx = x + dx;
-        int ny = y + dy;
-        
-        if (!isValid(nx, ny)) {
+    for (size_t i = 0; i < offsets_.size(); ++i) {
+        // Skip if already visited (guard cells always are)
+        PixelState& state = state_[index + neighbor_deltas_[i]];
+        if (state != PixelState::Unvisited) {
             continue;
         }
         
-        // Skip if already visited
-        if (state_[ny][nx] != PixelState::Unvisited) {
-            continue;
-        }
+        int nx = x + offsets_[i].first;
+        int ny = y + offsets_[i].second;
         
         // Check if neighbor has the same value
         if (source_.get(nx, ny) != target_value_) {
             // This is a boundary pixel
-            state_[ny][nx] = PixelState::Boundary;
+            state = PixelState::Boundary;
             continue;
         }
         
         // Check if the safety circle fits at this position
         if (!safety_mask_.get(nx, ny)) {
             // Circle doesn't fit - mark as unsafe but don't add to frontier
-            state_[ny][nx] = PixelState::Unsafe;
+            state = PixelState::Unsafe;
             unsafe_count_++;
             continue;
         }
         
         // Safe to fill - add to frontier
         frontier_.push_back({nx, ny});
-        state_[ny][nx] = PixelState::InQueue;
+        state = PixelState::InQueue;
     }
     
     return !frontier_.empty();
 }
 
+size_t FloodFill::step(size_t count) {
+    for (size_t taken = 0; taken < count; ++taken) {
+        if (!initialized_ || frontier_.empty()) {
+            return taken;
+        }
+        step();
+    }
+    return count;
+}
+
+size_t FloodFill::stepFor(int64_t microseconds) {
+    return runForBudget(microseconds, [this](size_t count) { return step(count); });
+}
+
+bool FloodFill::admitPixel(int x, int y) {
+    // Guard cells read as Boundary, so x and y may be one pixel outside
+    PixelState& state = state_[stateIndex(x, y)];
+    if (state == PixelState::InQueue) {
+        return true;
+    }
+    if (state != PixelState::Unvisited) {
+        return false;
+    }
+    
+    // Same classification as the per-pixel neighbor check in step()
+    if (source_.get(x, y) != target_value_) {
+        state = PixelState::Boundary;
+        return false;
+    }
+    if (!safety_mask_.get(x, y)) {
+        state = PixelState::Unsafe;
+        unsafe_count_++;
+        return false;
+    }
+    return true;
+}
+
+bool FloodFill::stepScanline() {
+    // Skip seeds whose span was already filled from another seed
+    std::pair<int, int> seed;
+    do {
+        if (frontier_.empty()) {
+            return false;
+        }
+        seed = frontier_.back();
+        frontier_.pop_back();
+    } while (state_[stateIndex(seed.first, seed.second)] == PixelState::Processed);
+    
+    int y = seed.second;
+    current_pixel_ = seed;
+    
+    // Grow the span left and right. The pixels where it stops are
+    // neighbors of the span and get classified on the way.
+    int x0 = seed.first;
+    int x1 = seed.first;
+    while (admitPixel(x0 - 1, y)) {
+        --x0;
+    }
+    while (admitPixel(x1 + 1, y)) {
+        ++x1;
+    }
+    
+    PixelState* span = &state_[stateIndex(x0, y)];
+    std::fill(span, span + (x1 - x0 + 1), PixelState::Processed);
+    for (int x = x0; x <= x1; ++x) {
+        result_.set(x, y, true);
+    }
+    filled_count_ += x1 - x0 + 1;
+    
+    // Scan the rows above and below; 8-connectivity also reaches the
+    // diagonal pixels past both ends of the span. Each run of fillable
+    // pixels gets a single seed.
+    int reach = connectivity_ == Connectivity::Eight ? 1 : 0;
+    for (int ny : {y - 1, y + 1}) {
+        bool in_run = false;
+        for (int nx = x0 - reach; nx <= x1 + reach; ++nx) {
+            if (!admitPixel(nx, ny)) {
+                in_run = false;
+                continue;
+            }
+            if (!in_run) {
+                frontier_.push_back({nx, ny});
+                in_run = true;
+            }
+            state_[stateIndex(nx, ny)] = PixelState::InQueue;
+        }
+    }
+    
+    return !frontier_.empty();
+}
+
+void FloodFill::syncVisited() {
+    std::vector<std::atomic<uint64_t>>& words = visited_.words;
+    if (words.size() != (state_.size() + 63) / 64) {
+        words = std::vector<std::atomic<uint64_t>>((state_.size() + 63) / 64);
+    }
+    for (size_t i = 0; i < words.size(); ++i) {
+        size_t end = std::min(state_.size(), (i + 1) * 64);
+        uint64_t bits = 0;
+        for (size_t j = i * 64; j < end; ++j) {
+            bits |= uint64_t(state_[j] != PixelState::Unvisited) << (j % 64);
+        }
+        words[i].store(bits, std::memory_order_relaxed);
+    }
+    visited_.valid = true;
+}
+
+bool FloodFill::stepLevel() {
+    if (!visited_.valid) {
+        syncVisited();
+    }
+    
+    // The frontier is one BFS layer, or several right after a switch from
+    // BFS or DFS mid-fill. Split it into chunks that each collect the
+    // neighbors they claim first.
+    constexpr size_t kMinChunkPixels = 256;
+    size_t count = frontier_.size();
+    int threads = getThreadCount();
+    int chunks = threads == 1 ? 1 : static_cast<int>(std::max<size_t>(1,
+        std::min<size_t>(static_cast<size_t>(threads) * 4, count / kMinChunkPixels)));
+    level_buffers_.resize(std::max<size_t>(level_buffers_.size(), chunks));
+    std::vector<size_t> unsafe(chunks, 0);
+    current_pixel_ = frontier_.front();
+    
+    auto expand = [&](int chunk) {
+        std::vector<std::pair<int, int>>& next = level_buffers_[chunk];
+        next.clear();
+        size_t end = count * (chunk + 1) / chunks;
+        for (size_t i = count * chunk / chunks; i < end; ++i) {
+            auto [x, y] = frontier_[i];
+            size_t index = stateIndex(x, y);
+            state_[index] = PixelState::Processed;
+            for (size_t k = 0; k < offsets_.size(); ++k) {
+                // Guard cells start claimed, like their Boundary state.
+                // Most neighbors were claimed earlier, so test before the
+                // locked fetch_or.
+                size_t neighbor = index + neighbor_deltas_[k];
+                std::atomic<uint64_t>& word = visited_.words[neighbor / 64];
+                uint64_t bit = uint64_t(1) << (neighbor % 64);
+                if ((word.load(std::memory_order_relaxed) & bit) ||
+                    (word.fetch_or(bit, std::memory_order_relaxed) & bit)) {
+                    continue;
+                }
+                
+                // Same classification as the serial step(); the claim makes
+                // this thread the only writer of the neighbor's state
+                int nx = x + offsets_[k].first;
+                int ny = y + offsets_[k].second;
+                if (source_.get(nx, ny) != target_value_) {
+                    state_[neighbor] = PixelState::Boundary;
+                } else if (!safety_mask_.get(nx, ny)) {
+                    state_[neighbor] = PixelState::Unsafe;
+                    unsafe[chunk]++;
+                } else {
+                    state_[neighbor] = PixelState::InQueue;
+                    next.emplace_back(nx, ny);
+                }
+            }
+        }
+    };
+    if (pool_ && chunks > 1) {
+        pool_->parallelFor(chunks, expand);
+    } else {
+        expand(0);
+    }
+    
+    // Fill the layer and merge the next one in chunk order
+    for (size_t i = 0; i < count; ++i) {
+        result_.set(frontier_[i].first, frontier_[i].second, true);
+    }
+    filled_count_ += count;
+    frontier_.clear();
+    for (int chunk = 0; chunk < chunks; ++chunk) {
+        unsafe_count_ += unsafe[chunk];
+        frontier_.insert(frontier_.end(), level_buffers_[chunk].begin(), level_buffers_[chunk].end());
+    }
+    
+    return !frontier_.empty();
+}
+
+void FloodFill::setThreadCount(int threads) {
+    if (threads == 1) {
+        pool_.reset();
+    } else {
+        pool_ = std::make_shared<ThreadPool>(threads);
+    }
+}
+
+int FloodFill::getThreadCount() const {
+    return pool_ ? pool_->threadCount() : 1;
+}
+
 PixelState FloodFill::getState(int x, int y) const {
     if (!isValid(x, y)) {
         return PixelState::Unvisited;
     }
-    return state_[y][x];
+    return state_[stateIndex(x, y)];
 }
 
 std::vector<std::pair<int, int>> FloodFill::getFrontierPositions() const {
@@ -2,22 +2,25 @@
 #define FLOODFILL_HPP
 
 #include "binary_image.hpp"
+#include "connected_components.hpp"
+#include "distance_transform.hpp"
+#include "thread_pool.hpp"
+#include "tile_map.hpp"
+#include <atomic>
+#include <memory>
 #include <queue>
 #include <stack>
 #include <vector>
 #include <utility>
 #include <cmath>
-
-// Connectivity options for neighbor lookup
-enum class Connectivity {
-    Four,   // N, S, E, W only
-    Eight   // Includes diagonals
-};
+#include <cstddef>
 
 // Traversal strategy
 enum class FillAlgorithm {
-    BFS,    // Queue-based, spreads uniformly
-    DFS     // Stack-based, explores depth first
+    BFS,        // Queue-based, spreads uniformly
+    DFS,        // Stack-based, explores depth first
+    Scanline,   // Span-based, fills a whole horizontal run per step
+    ParallelBFS // Level-synchronous BFS, fills a whole frontier per step
 };
 
 // Pixel states during fill animation
@@ -43,12 +46,27 @@ public:
               FillAlgorithm algorithm = FillAlgorithm::BFS,
               int safety_radius = 0);
 
-    // Reset and start fill from given position
-    void initialize(const BinaryImage& image, int start_x, int start_y);
+    // Reset and start fill from given position. Re-initializing with the
+    // same image content reuses the cached clearance field, so changing the
+    // safety radius only costs a threshold pass. The image may be a view of
+    // a rectangle of a larger map; its pixels are copied once, since the
+    // fill reads them on every later step().
+    void initialize(const BinaryImageView& image, int start_x, int start_y);
 
-    // Process next pixel in queue/stack. Returns false when done.
+    // Process next pixel in queue/stack (or next span for Scanline, or
+    // every pixel of the current BFS layer for ParallelBFS).
+    // Returns false when done.
     bool step();
 
+    // Take up to `count` steps. Returns the number taken, fewer than
+    // `count` only if the fill completed.
+    size_t step(size_t count);
+
+    // Take steps until the fill completes or about `microseconds` have
+    // passed, for animation at a fixed frame budget. At least one step is
+    // taken. Returns the number taken.
+    size_t stepFor(int64_t microseconds);
+
     bool isComplete() const { return frontier_.empty() && initialized_; }
 
     PixelState getState(int x, int y) const;
@@ -75,29 +93,76 @@ public:
     int getSafetyRadius() const { return safety_radius_; }
     
     void setConnectivity(Connectivity c) { connectivity_ = c; updateOffsets(); }
-    void setAlgorithm(FillAlgorithm a) { algorithm_ = a; }
+    // May be called mid-fill; the frontier is converted to the new algorithm
+    void setAlgorithm(FillAlgorithm a);
     void setSafetyRadius(int r) { safety_radius_ = r; updateDiskOffsets(); }
 
+    // Expand ParallelBFS layers on a pool of threads (1: serial, <= 0: one
+    // per hardware thread). Steps, counts and states are the same for any
+    // thread count; only the order of pixels within a layer may differ.
+    // Each step expands the whole frontier, which is one BFS layer unless
+    // the fill switched from BFS or DFS mid-fill: the first step then
+    // expands everything they had queued, which may span several layers.
+    // Copies of this object share the pool.
+    void setThreadCount(int threads);
+    int getThreadCount() const;
+
 private:
     void updateOffsets();
+    void updateNeighborDeltas();
     void updateDiskOffsets();
     void precomputeSafetyMask();
+    const DistanceField& clearanceField();
     bool isValid(int x, int y) const;
+    size_t stateIndex(int x, int y) const {
+        return static_cast<size_t>(y + 1) * state_stride_ + (x + 1);
+    }
+    bool stepScanline();
+    bool stepLevel();
+    void syncVisited();
+    bool admitPixel(int x, int y);
 
     Connectivity connectivity_;
     FillAlgorithm algorithm_;
     int safety_radius_;
     
     std::vector<std::pair<int, int>> offsets_;
+    std::vector<std::ptrdiff_t> neighbor_deltas_;  // offsets_ as state_ index deltas
     std::vector<std::pair<int, int>> disk_offsets_;
     
     BinaryImage source_;
     BinaryImage result_;
     BinaryImage safety_mask_;
-    std::vector<std::vector<PixelState>> state_;
+    
+    // Distance to the nearest non-target pixel, per target value. Depends
+    // only on source_, so it survives radius changes.
+    DistanceField clearance_[2];
+    bool clearance_valid_[2] = {false, false};
+    // Occupancy of source_, so uniform tiles skip the safety threshold
+    TileMap tiles_;
+    // Row-major with a one-pixel guard ring: (width_ + 2) x (height_ + 2)
+    std::vector<PixelState> state_;
+    int state_stride_ = 2;
     
     std::deque<std::pair<int, int>> frontier_;
     
+    // Pixels no longer Unvisited, one bit per state_ cell, for ParallelBFS.
+    // Threads claim a neighbor with an atomic fetch_or, so each pixel is
+    // classified by exactly one thread. Rebuilt from state_ after steps of
+    // the other algorithms, and by copies, which start without it.
+    struct VisitedBits {
+        std::vector<std::atomic<uint64_t>> words;
+        bool valid = false;
+
+        VisitedBits() = default;
+        VisitedBits(const VisitedBits&) {}
+        VisitedBits& operator=(const VisitedBits&) { valid = false; return *this; }
+    };
+    VisitedBits visited_;
+    // Next layer found by each chunk of the current one
+    std::vector<std::vector<std::pair<int, int>>> level_buffers_;
+    std::shared_ptr<ThreadPool> pool_;
+    
     std::pair<int, int> current_pixel_{-1, -1};
     bool target_value_ = false;
     bool initialized_ = false;
@@ -109,11 +109,30 @@ void FloodFillVisualizer::resetFill() {
     paused_ = true;
     steps_count_ = 0;
     
+    configureFloodFill();
+}
+
+void FloodFillVisualizer::configureFloodFill() {
     Connectivity conn = controls_.selected_connectivity == 0 ? 
         Connectivity::Four : Connectivity::Eight;
-    FillAlgorithm algo = controls_.selected_algorithm == 0 ? 
-        FillAlgorithm::BFS : FillAlgorithm::DFS;
-    floodfill_ = std::make_unique<FloodFill>(conn, algo, controls_.safety_radius);
+    FillAlgorithm algo = static_cast<FillAlgorithm>(controls_.selected_algorithm);
+    
+    // Reuse the instance so its clearance cache survives radius changes
+    if (!floodfill_) {
+        floodfill_ = std::make_unique<FloodFill>(conn, algo, controls_.safety_radius);
+    } else {
+        floodfill_->setConnectivity(conn);
+        floodfill_->setAlgorithm(algo);
+        floodfill_->setSafetyRadius(controls_.safety_radius);
+    }
+    
+    // Layers of the parallel BFS spread over every hardware thread; the
+    // pool is created once and kept for later fills. Remembered here since
+    // the resolved count stays 1 on a single-core host.
+    if (algo == FillAlgorithm::ParallelBFS && !fill_pool_started_) {
+        floodfill_->setThreadCount(0);
+        fill_pool_started_ = true;
+    }
 }
 
 void FloodFillVisualizer::startFillAt(int x, int y) {
@@ -128,12 +147,7 @@ void FloodFillVisualizer::startFillAt(int x, int y) {
     paused_ = true;
     steps_count_ = 0;
     
-    Connectivity conn = controls_.selected_connectivity == 0 ? 
-        Connectivity::Four : Connectivity::Eight;
-    FillAlgorithm algo = controls_.selected_algorithm == 0 ? 
-        FillAlgorithm::BFS : FillAlgorithm::DFS;
-    
-    floodfill_ = std::make_unique<FloodFill>(conn, algo, controls_.safety_radius);
+    configureFloodFill();
     floodfill_->initialize(*source_image_, x, y);
 }
 
@@ -301,7 +315,7 @@ void FloodFillVisualizer::renderImGui() {
     
     // Algorithm
     ImGui::SeparatorText("Algorithm");
-    const char* algorithms[] = {"BFS (Breadth-First)", "DFS (Depth-First)"};
+    const char* algorithms[] = {"BFS (Breadth-First)", "DFS (Depth-First)", "Scanline (Spans)", "BFS Layers (Parallel)"};
     if (ImGui::Combo("Search", &controls_.selected_algorithm, algorithms, IM_ARRAYSIZE(algorithms))) {
         if (controls_.fill_started) {
             startFillAt(controls_.start_x, controls_.start_y);
@@ -337,6 +351,8 @@ void FloodFillVisualizer::renderImGui() {
     // Animation
     ImGui::SeparatorText("Animation");
     ImGui::SliderInt("Speed (ms)", &controls_.animation_speed, 5, 100);
+    ImGui::SliderInt("Budget (ms/frame)", &controls_.frame_budget_ms, 0, 16);
+    ImGui::TextWrapped("Budget 0: one step per tick\nBudget > 0: as many steps as fit per frame");
     
     if (!controls_.fill_started) {
         ImGui::TextColored(ImVec4(1, 0.8f, 0, 1), "Click grid to start");
@@ -468,12 +484,7 @@ bool FloodFillVisualizer::handleEvents() {
 void FloodFillVisualizer::run(std::function<BinaryImage(const FloodFillControls&)> createImageFunc) {
     create_image_func_ = createImageFunc;
     source_image_ = std::make_unique<BinaryImage>(createImageFunc(controls_));
-    
-    Connectivity conn = controls_.selected_connectivity == 0 ? 
-        Connectivity::Four : Connectivity::Eight;
-    FillAlgorithm algo = controls_.selected_algorithm == 0 ? 
-        FillAlgorithm::BFS : FillAlgorithm::DFS;
-    floodfill_ = std::make_unique<FloodFill>(conn, algo, controls_.safety_radius);
+    configureFloodFill();
 
     bool running = true;
     while (running) {
@@ -504,7 +515,13 @@ void FloodFillVisualizer::run(std::function<BinaryImage(const FloodFillControls&
         }
         
         // Animate
-        if (!paused_ && !completed_ && controls_.fill_started && floodfill_) {
+        if (!paused_ && !completed_ && controls_.fill_started && floodfill_ &&
+            controls_.frame_budget_ms > 0) {
+            // Large maps: fill the frame budget instead of waiting for ticks
+            steps_count_ += static_cast<int>(
+                floodfill_->stepFor(static_cast<int64_t>(controls_.frame_budget_ms) * 1000));
+            if (floodfill_->getFrontierSize() == 0) completed_ = true;
+        } else if (!paused_ && !completed_ && controls_.fill_started && floodfill_) {
             Uint32 current_time = SDL_GetTicks();
             if (current_time - last_step_time_ >= static_cast<Uint32>(controls_.animation_speed)) {
                 last_step_time_ = current_time;
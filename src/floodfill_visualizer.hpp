@@ -20,7 +20,7 @@ struct FloodFillControls {
     
     // Algorithm settings
     int selected_connectivity = 0;  // 0 = 4-connected, 1 = 8-connected
-    int selected_algorithm = 0;     // 0 = BFS, 1 = DFS
+    int selected_algorithm = 0;     // 0 = BFS, 1 = DFS, 2 = Scanline, 3 = Parallel BFS
     
     // Safety radius for clearance checking
     int safety_radius = 2;
@@ -28,6 +28,7 @@ struct FloodFillControls {
     
     // Animation timing
     int animation_speed = 30;
+    int frame_budget_ms = 0;  // 0: one step per speed tick
     
     // State
     bool needs_regenerate = false;
@@ -59,6 +60,7 @@ private:
     void renderGrid();
     bool handleEvents();
     void resetFill();
+    void configureFloodFill();
     void startFillAt(int x, int y);
     void updateHoverPosition(int mouse_x, int mouse_y);
 
@@ -77,6 +79,7 @@ private:
     FloodFillControls controls_;
     std::unique_ptr<BinaryImage> source_image_;
     std::unique_ptr<FloodFill> floodfill_;
+    bool fill_pool_started_ = false;  // floodfill_ has its ParallelBFS thread pool
     
     bool paused_ = true;
     bool completed_ = false;
@@ -38,7 +38,8 @@ int main(int argc, char* argv[]) {
 
     std::cout << "Morphology Demo\n";
     std::cout << "---------------\n\n";
-    std::cout << "Operations: Erosion, Dilation, Inner/Outer Boundary, Gradient\n";
+    std::cout << "Operations: Erosion, Dilation, Inner/Outer Boundary, Gradient,\n";
+    std::cout << "            Opening, Closing, White/Black Top-Hat\n";
     std::cout << "Use the control panel to configure parameters.\n\n";
     std::cout << "Controls:\n";
     std::cout << "  Space  - Play/Pause\n";
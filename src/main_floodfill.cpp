@@ -2,7 +2,7 @@
  * Flood Fill Demo
  *
  * Interactive visualization of the flood fill algorithm with support for:
- * - BFS and DFS traversal
+ * - BFS, DFS and scanline (span) traversal
  * - 4-connected and 8-connected neighborhoods
  * - Safety radius constraint for clearance-based filling
  */
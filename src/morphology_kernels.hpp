@@ -0,0 +1,305 @@
+#ifndef MORPHOLOGY_KERNELS_HPP
+#define MORPHOLOGY_KERNELS_HPP
+
+#include "binary_image.hpp"
+#include "row_kernels.hpp"
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstring>
+#include <utility>
+#include <vector>
+
+// The kernels must be inlined into the per-instruction-set wrappers in
+// row_kernels.cpp, which is where their vectors get the target's width
+#if defined(__GNUC__) || defined(__clang__)
+#define MORPHOLOGY_KERNELS_INLINE inline __attribute__((always_inline))
+#else
+#define MORPHOLOGY_KERNELS_INLINE inline
+#endif
+
+/**
+ * @brief Bitwise erosion/dilation kernels specialized at compile time for
+ * fixed structuring element shapes.
+ *
+ * Each shape lists its offsets as a constexpr table, so the kernel unrolls
+ * every SE term into a single pass over the row with constant shift
+ * amounts, instead of one pass per term driven by a runtime offset list.
+ * The kernels are generic over the number of words per vector;
+ * row_kernels.cpp instantiates them for each instruction set and
+ * RowKernels::shapes holds the active ones.
+ */
+namespace morphology_kernels {
+
+using Word = BinaryImage::Word;
+constexpr int kWordBits = BinaryImage::kWordBits;
+
+struct Offset {
+    int dx;
+    int dy;
+};
+
+/**
+ * @brief Full N x N square (N odd).
+ */
+template <int N>
+struct Square {
+    static_assert(N % 2 == 1 && N >= 3, "Square size must be odd and >= 3");
+    static constexpr int kReach = N / 2;
+    static constexpr std::size_t kCount = N * N;
+
+    static constexpr std::array<Offset, kCount> makeOffsets() {
+        std::array<Offset, kCount> offsets{};
+        std::size_t i = 0;
+        for (int dy = -kReach; dy <= kReach; ++dy) {
+            for (int dx = -kReach; dx <= kReach; ++dx) {
+                offsets[i++] = {dx, dy};
+            }
+        }
+        return offsets;
+    }
+
+    static constexpr std::array<Offset, kCount> kOffsets = makeOffsets();
+};
+
+/**
+ * @brief Plus-shaped cross with arms of length N / 2 (N odd).
+ */
+template <int N>
+struct Cross {
+    static_assert(N % 2 == 1 && N >= 3, "Cross size must be odd and >= 3");
+    static constexpr int kReach = N / 2;
+    static constexpr std::size_t kCount = 2 * N - 1;
+
+    static constexpr std::array<Offset, kCount> makeOffsets() {
+        std::array<Offset, kCount> offsets{};
+        std::size_t i = 0;
+        for (int d = -kReach; d <= kReach; ++d) {
+            offsets[i++] = {d, 0};
+            if (d != 0) {
+                offsets[i++] = {0, d};
+            }
+        }
+        return offsets;
+    }
+
+    static constexpr std::array<Offset, kCount> kOffsets = makeOffsets();
+};
+
+/**
+ * @brief Digital disk of radius R: every offset with dx^2 + dy^2 <= R^2.
+ */
+template <int R>
+struct Disk {
+    static_assert(R >= 1, "Disk radius must be >= 1");
+    static constexpr int kReach = R;
+
+    static constexpr std::size_t count() {
+        std::size_t n = 0;
+        for (int dy = -R; dy <= R; ++dy) {
+            for (int dx = -R; dx <= R; ++dx) {
+                n += dx * dx + dy * dy <= R * R;
+            }
+        }
+        return n;
+    }
+
+    static constexpr std::size_t kCount = count();
+
+    static constexpr std::array<Offset, kCount> makeOffsets() {
+        std::array<Offset, kCount> offsets{};
+        std::size_t i = 0;
+        for (int dy = -R; dy <= R; ++dy) {
+            for (int dx = -R; dx <= R; ++dx) {
+                if (dx * dx + dy * dy <= R * R) {
+                    offsets[i++] = {dx, dy};
+                }
+            }
+        }
+        return offsets;
+    }
+
+    static constexpr std::array<Offset, kCount> kOffsets = makeOffsets();
+};
+
+/**
+ * @brief Call visit(FixedShape, Shape{}) for every fixed shape, in enum order.
+ */
+template <typename Visit>
+void forEachFixedShape(Visit visit) {
+    visit(FixedShape::Square3, Square<3>{});
+    visit(FixedShape::Square5, Square<5>{});
+    visit(FixedShape::Square7, Square<7>{});
+    visit(FixedShape::Cross3, Cross<3>{});
+    visit(FixedShape::Cross5, Cross<5>{});
+    visit(FixedShape::Cross7, Cross<7>{});
+    visit(FixedShape::Disk2, Disk<2>{});
+    visit(FixedShape::Disk3, Disk<3>{});
+}
+
+/**
+ * @brief Find the fixed shape a runtime offset list describes exactly.
+ * @param offsets SE offsets; order and duplicates are ignored
+ * @param shape Receives the shape
+ * @return false if the offsets are not one of the fixed shapes
+ *
+ * Sorts a copy of the offsets, so callers should match once per SE.
+ */
+inline bool findFixedShape(const std::vector<std::pair<int, int>>& offsets, FixedShape& shape) {
+    std::vector<std::pair<int, int>> actual(offsets);
+    std::sort(actual.begin(), actual.end());
+    actual.erase(std::unique(actual.begin(), actual.end()), actual.end());
+
+    // Both lists are free of duplicates, so same size and inclusion is equality
+    bool found = false;
+    forEachFixedShape([&](FixedShape candidate, auto shape_type) {
+        using Shape = decltype(shape_type);
+        if (found || actual.size() != Shape::kCount) {
+            return;
+        }
+        for (const Offset& offset : Shape::kOffsets) {
+            if (!std::binary_search(actual.begin(), actual.end(), std::make_pair(offset.dx, offset.dy))) {
+                return;
+            }
+        }
+        shape = candidate;
+        found = true;
+    });
+    return found;
+}
+
+/**
+ * @brief Lanes consecutive words as one GCC vector; a plain Word for 1.
+ */
+template <int Lanes>
+struct WordVector {
+    typedef Word Type __attribute__((vector_size(Lanes * sizeof(Word))));
+};
+
+template <>
+struct WordVector<1> {
+    using Type = Word;
+};
+
+/**
+ * @brief Word i of a row shifted so that bit x holds pixel x + Dx.
+ *
+ * The row must be readable one word before and after its pixel words.
+ */
+template <int Dx>
+inline Word shiftedWord(const Word* row, int i) {
+    constexpr int s = Dx & (kWordBits - 1);
+    constexpr int base = (Dx - s) / kWordBits;
+    if constexpr (s == 0) {
+        return row[i + base];
+    } else {
+        return (row[i + base] >> s) | (row[i + base + 1] << (kWordBits - s));
+    }
+}
+
+/**
+ * @brief Words i .. i + lanes - 1 of a row shifted like shiftedWord().
+ *
+ * Loads are unaligned; the row must be readable as for shiftedWord().
+ */
+template <int Dx, typename Vector>
+MORPHOLOGY_KERNELS_INLINE void shiftedWords(const Word* row, int i, Vector& out) {
+    constexpr int s = Dx & (kWordBits - 1);
+    constexpr int base = (Dx - s) / kWordBits;
+    std::memcpy(&out, row + i + base, sizeof(out));
+    if constexpr (s != 0) {
+        Vector next;
+        std::memcpy(&next, row + i + base + 1, sizeof(next));
+        out = (out >> s) | (next << (kWordBits - s));
+    }
+}
+
+template <typename Shape, bool Erode, int Lanes, std::size_t... I>
+MORPHOLOGY_KERNELS_INLINE void shapeRowImpl(const Word* const* rows, int words, Word* out,
+                                            std::index_sequence<I...>) {
+    using Vector = typename WordVector<Lanes>::Type;
+    constexpr auto& offsets = Shape::kOffsets;
+    int i = 0;
+    if constexpr (Lanes > 1) {
+        for (; i + Lanes <= words; i += Lanes) {
+            Vector acc = {};
+            if constexpr (Erode) {
+                acc = ~acc;
+            }
+            Vector term;
+            ((shiftedWords<offsets[I].dx>(rows[offsets[I].dy + Shape::kReach], i, term),
+              acc = Erode ? (acc & term) : (acc | term)), ...);
+            std::memcpy(out + i, &acc, sizeof(acc));
+        }
+    }
+    for (; i < words; ++i) {
+        if constexpr (Erode) {
+            out[i] = (shiftedWord<offsets[I].dx>(rows[offsets[I].dy + Shape::kReach], i) & ...);
+        } else {
+            out[i] = (shiftedWord<offsets[I].dx>(rows[offsets[I].dy + Shape::kReach], i) | ...);
+        }
+    }
+}
+
+/**
+ * @brief Erosion (AND) or dilation (OR) of one output row by Shape.
+ * @tparam Lanes Words per vector step; the last words run one at a time
+ * @param rows 2 * kReach + 1 row pointers, rows[k] being the source row at
+ *        dy = k - kReach, each readable kReach pixels (and at least one
+ *        word) beyond both ends
+ * @param words Number of output words
+ * @param out Output words
+ */
+template <typename Shape, bool Erode, int Lanes = 1>
+MORPHOLOGY_KERNELS_INLINE void shapeRow(const Word* const* rows, int words, Word* out) {
+    shapeRowImpl<Shape, Erode, Lanes>(rows, words, out, std::make_index_sequence<Shape::kCount>());
+}
+
+template <typename Shape, int Lanes, std::size_t... I>
+MORPHOLOGY_KERNELS_INLINE void shapeMinMaxRowImpl(const Word* const* rows, int words, Word* lo, Word* hi,
+                                                  std::index_sequence<I...>) {
+    using Vector = typename WordVector<Lanes>::Type;
+    constexpr auto& offsets = Shape::kOffsets;
+    int i = 0;
+    if constexpr (Lanes > 1) {
+        for (; i + Lanes <= words; i += Lanes) {
+            Vector l = {};
+            Vector h = {};
+            l = ~l;
+            Vector term;
+            ((shiftedWords<offsets[I].dx>(rows[offsets[I].dy + Shape::kReach], i, term),
+              l &= term, h |= term), ...);
+            std::memcpy(lo + i, &l, sizeof(l));
+            std::memcpy(hi + i, &h, sizeof(h));
+        }
+    }
+    for (; i < words; ++i) {
+        const Word terms[] = {shiftedWord<offsets[I].dx>(rows[offsets[I].dy + Shape::kReach], i)...};
+        Word l = ~Word(0);
+        Word h = 0;
+        ((l &= terms[I], h |= terms[I]), ...);
+        lo[i] = l;
+        hi[i] = h;
+    }
+}
+
+/**
+ * @brief Erosion and dilation of one output row by Shape in a single pass.
+ *
+ * Each shifted term is computed once and feeds both the AND and the OR,
+ * which is what composites such as the gradient need.
+ * @param rows Source rows, as for shapeRow()
+ * @param words Number of output words
+ * @param lo Eroded output words
+ * @param hi Dilated output words
+ */
+template <typename Shape, int Lanes = 1>
+MORPHOLOGY_KERNELS_INLINE void shapeMinMaxRow(const Word* const* rows, int words, Word* lo, Word* hi) {
+    shapeMinMaxRowImpl<Shape, Lanes>(rows, words, lo, hi, std::make_index_sequence<Shape::kCount>());
+}
+
+} // namespace morphology_kernels
+
+#undef MORPHOLOGY_KERNELS_INLINE
+
+#endif // MORPHOLOGY_KERNELS_HPP
@@ -0,0 +1,512 @@
+#include "row_kernels.hpp"
+#include "morphology_kernels.hpp"
+#include <algorithm>
+#include <array>
+#include <atomic>
+
+#if (defined(__GNUC__) || defined(__clang__)) && (defined(__x86_64__) || defined(__i386__))
+#define ROW_KERNELS_X86 1
+#include <immintrin.h>
+#endif
+
+// The scalar helpers must be inlined into the vector variants: a call (or
+// tail call) to legacy-SSE code with dirty upper vector registers costs an
+// AVX/SSE transition on every row.
+#if defined(__GNUC__) || defined(__clang__)
+#define ROW_KERNELS_INLINE inline __attribute__((always_inline))
+#else
+#define ROW_KERNELS_INLINE inline
+#endif
+
+namespace {
+    using Word = BinaryImage::Word;
+    constexpr int kWordBits = BinaryImage::kWordBits;
+
+    template <RowOp Op>
+    ROW_KERNELS_INLINE Word applyOp(Word a, Word b) {
+        if constexpr (Op == RowOp::And) return a & b;
+        else if constexpr (Op == RowOp::Or) return a | b;
+        else if constexpr (Op == RowOp::AndNot) return a & ~b;
+        else return a ^ b;
+    }
+
+    // Word i of `src` shifted right by s bits, pulling bits from word i + 1
+    ROW_KERNELS_INLINE Word shiftedWord(const Word* src, int i, int s) {
+        return s == 0 ? src[i] : (src[i] >> s) | (src[i + 1] << (kWordBits - s));
+    }
+
+    // Scalar loops; the vector variants use them for their tails
+    template <RowOp Op>
+    ROW_KERNELS_INLINE void combineTail(Word* out, const Word* a, const Word* b, int begin, int words) {
+        for (int i = begin; i < words; ++i) {
+            out[i] = applyOp<Op>(a[i], b[i]);
+        }
+    }
+
+    template <RowOp Op>
+    ROW_KERNELS_INLINE void combineShiftedTail(Word* out, const Word* a, const Word* src, int begin, int words, int s) {
+        for (int i = begin; i < words; ++i) {
+            out[i] = applyOp<Op>(a[i], shiftedWord(src, i, s));
+        }
+    }
+
+    ROW_KERNELS_INLINE void minMaxShiftedTail(Word* lo, Word* hi, const Word* src, int begin, int words, int s) {
+        for (int i = begin; i < words; ++i) {
+            Word v = shiftedWord(src, i, s);
+            lo[i] &= v;
+            hi[i] |= v;
+        }
+    }
+
+    // Split dx into a word offset and a right shift in [0, 64)
+    ROW_KERNELS_INLINE const Word* shiftSource(const Word* row, int dx, int& s) {
+        s = dx & (kWordBits - 1);
+        return row + (dx - s) / kWordBits;
+    }
+
+    // Entry points of one instruction set, dispatching the op to its
+    // combine<SUFFIX>Loop, combineShifted<SUFFIX>Loop and
+    // minMaxShifted<SUFFIX>Loop loops, and the fixed-shape kernels at
+    // k<SUFFIX>Lanes words per vector
+#define ROW_KERNELS_ENTRY_POINTS(SUFFIX, ...)                                               \
+    __VA_ARGS__ void combine##SUFFIX(RowOp op, Word* out, const Word* a, const Word* b,     \
+                                     int words) {                                          \
+        switch (op) {                                                                      \
+            case RowOp::And: combine##SUFFIX##Loop<RowOp::And>(out, a, b, words); break;   \
+            case RowOp::Or: combine##SUFFIX##Loop<RowOp::Or>(out, a, b, words); break;     \
+            case RowOp::AndNot: combine##SUFFIX##Loop<RowOp::AndNot>(out, a, b, words); break; \
+            case RowOp::Xor: combine##SUFFIX##Loop<RowOp::Xor>(out, a, b, words); break;   \
+        }                                                                                  \
+    }                                                                                      \
+    __VA_ARGS__ void combineShifted##SUFFIX(RowOp op, Word* out, const Word* a,            \
+                                            const Word* row, int words, int dx) {          \
+        int s;                                                                             \
+        const Word* src = shiftSource(row, dx, s);                                         \
+        switch (op) {                                                                      \
+            case RowOp::And: combineShifted##SUFFIX##Loop<RowOp::And>(out, a, src, words, s); break; \
+            case RowOp::Or: combineShifted##SUFFIX##Loop<RowOp::Or>(out, a, src, words, s); break; \
+            case RowOp::AndNot: combineShifted##SUFFIX##Loop<RowOp::AndNot>(out, a, src, words, s); break; \
+            case RowOp::Xor: combineShifted##SUFFIX##Loop<RowOp::Xor>(out, a, src, words, s); break; \
+        }                                                                                  \
+    }                                                                                      \
+    __VA_ARGS__ void minMaxShifted##SUFFIX(Word* lo, Word* hi, const Word* row, int words, \
+                                           int dx) {                                       \
+        int s;                                                                             \
+        const Word* src = shiftSource(row, dx, s);                                         \
+        minMaxShifted##SUFFIX##Loop(lo, hi, src, words, s);                                \
+    }                                                                                      \
+    template <typename Shape, bool Erode>                                                  \
+    __VA_ARGS__ void shapeRow##SUFFIX(const Word* const* rows, int words, Word* out) {     \
+        morphology_kernels::shapeRow<Shape, Erode, k##SUFFIX##Lanes>(rows, words, out);    \
+    }                                                                                      \
+    template <typename Shape>                                                              \
+    __VA_ARGS__ void shapeMinMaxRow##SUFFIX(const Word* const* rows, int words, Word* lo,  \
+                                            Word* hi) {                                    \
+        morphology_kernels::shapeMinMaxRow<Shape, k##SUFFIX##Lanes>(rows, words, lo, hi);  \
+    }                                                                                      \
+    std::array<ShapeRowKernels, kFixedShapeCount> makeShapeKernels##SUFFIX() {             \
+        std::array<ShapeRowKernels, kFixedShapeCount> kernels{};                           \
+        morphology_kernels::forEachFixedShape([&](FixedShape shape, auto shape_type) {     \
+            using Shape = decltype(shape_type);                                            \
+            kernels[static_cast<int>(shape)] = {Shape::kReach, &shapeRow##SUFFIX<Shape, true>, \
+                                                &shapeRow##SUFFIX<Shape, false>,           \
+                                                &shapeMinMaxRow##SUFFIX<Shape>};           \
+        });                                                                                \
+        return kernels;                                                                    \
+    }                                                                                      \
+    const std::array<ShapeRowKernels, kFixedShapeCount> k##SUFFIX##ShapeKernels =          \
+        makeShapeKernels##SUFFIX();
+
+    // Scalar
+
+    template <RowOp Op>
+    void combineScalarLoop(Word* out, const Word* a, const Word* b, int words) {
+        combineTail<Op>(out, a, b, 0, words);
+    }
+
+    template <RowOp Op>
+    void combineShiftedScalarLoop(Word* out, const Word* a, const Word* src, int words, int s) {
+        combineShiftedTail<Op>(out, a, src, 0, words, s);
+    }
+
+    void minMaxShiftedScalarLoop(Word* lo, Word* hi, const Word* src, int words, int s) {
+        minMaxShiftedTail(lo, hi, src, 0, words, s);
+    }
+
+    void fillScalar(Word* out, Word value, int words) {
+        std::fill(out, out + words, value);
+    }
+
+    void copyScalar(Word* out, const Word* src, int words) {
+        std::copy(src, src + words, out);
+    }
+
+    constexpr int kScalarLanes = 1;
+
+    ROW_KERNELS_ENTRY_POINTS(Scalar)
+
+#ifdef ROW_KERNELS_X86
+    // SSE2: 2 words per vector
+
+    template <RowOp Op>
+    __attribute__((target("sse2"))) __m128i applyOpSse2(__m128i a, __m128i b) {
+        if constexpr (Op == RowOp::And) return _mm_and_si128(a, b);
+        else if constexpr (Op == RowOp::Or) return _mm_or_si128(a, b);
+        else if constexpr (Op == RowOp::AndNot) return _mm_andnot_si128(b, a);
+        else return _mm_xor_si128(a, b);
+    }
+
+    template <RowOp Op>
+    __attribute__((target("sse2"))) void combineSse2Loop(Word* out, const Word* a, const Word* b, int words) {
+        int i = 0;
+        for (; i + 2 <= words; i += 2) {
+            __m128i va = _mm_loadu_si128(reinterpret_cast<const __m128i*>(a + i));
+            __m128i vb = _mm_loadu_si128(reinterpret_cast<const __m128i*>(b + i));
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(out + i), applyOpSse2<Op>(va, vb));
+        }
+        combineTail<Op>(out, a, b, i, words);
+    }
+
+    template <RowOp Op>
+    __attribute__((target("sse2"))) void combineShiftedSse2Loop(Word* out, const Word* a, const Word* src, int words, int s) {
+        __m128i right = _mm_cvtsi32_si128(s);
+        __m128i left = _mm_cvtsi32_si128(kWordBits - s);
+        int i = 0;
+        if (s == 0) {
+            for (; i + 2 <= words; i += 2) {
+                __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i));
+                __m128i va = _mm_loadu_si128(reinterpret_cast<const __m128i*>(a + i));
+                _mm_storeu_si128(reinterpret_cast<__m128i*>(out + i), applyOpSse2<Op>(va, v));
+            }
+        } else if (words >= 3) {
+            // The word after each lane comes from a shuffle, not an offset load
+            __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src));
+            for (; i + 4 <= words + 1; i += 2) {
+                __m128i following = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i + 2));
+                __m128i next = _mm_castpd_si128(_mm_shuffle_pd(_mm_castsi128_pd(v), _mm_castsi128_pd(following), 1));
+                __m128i shifted = _mm_or_si128(_mm_srl_epi64(v, right), _mm_sll_epi64(next, left));
+                __m128i va = _mm_loadu_si128(reinterpret_cast<const __m128i*>(a + i));
+                _mm_storeu_si128(reinterpret_cast<__m128i*>(out + i), applyOpSse2<Op>(va, shifted));
+                v = following;
+            }
+        }
+        combineShiftedTail<Op>(out, a, src, i, words, s);
+    }
+
+    __attribute__((target("sse2"))) void minMaxShiftedSse2Loop(Word* lo, Word* hi, const Word* src, int words, int s) {
+        __m128i right = _mm_cvtsi32_si128(s);
+        __m128i left = _mm_cvtsi32_si128(kWordBits - s);
+        auto update = [&](int i, __m128i v) __attribute__((target("sse2"))) {
+            __m128i* l = reinterpret_cast<__m128i*>(lo + i);
+            __m128i* h = reinterpret_cast<__m128i*>(hi + i);
+            _mm_storeu_si128(l, _mm_and_si128(_mm_loadu_si128(l), v));
+            _mm_storeu_si128(h, _mm_or_si128(_mm_loadu_si128(h), v));
+        };
+        int i = 0;
+        if (s == 0) {
+            for (; i + 2 <= words; i += 2) {
+                update(i, _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i)));
+            }
+        } else if (words >= 3) {
+            __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src));
+            for (; i + 4 <= words + 1; i += 2) {
+                __m128i following = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i + 2));
+                __m128i next = _mm_castpd_si128(_mm_shuffle_pd(_mm_castsi128_pd(v), _mm_castsi128_pd(following), 1));
+                update(i, _mm_or_si128(_mm_srl_epi64(v, right), _mm_sll_epi64(next, left)));
+                v = following;
+            }
+        }
+        minMaxShiftedTail(lo, hi, src, i, words, s);
+    }
+
+    __attribute__((target("sse2"))) void fillSse2(Word* out, Word value, int words) {
+        __m128i v = _mm_set1_epi64x(static_cast<long long>(value));
+        int i = 0;
+        for (; i + 2 <= words; i += 2) {
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(out + i), v);
+        }
+        for (; i < words; ++i) {
+            out[i] = value;
+        }
+    }
+
+    __attribute__((target("sse2"))) void copySse2(Word* out, const Word* src, int words) {
+        int i = 0;
+        for (; i + 2 <= words; i += 2) {
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(out + i),
+                             _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i)));
+        }
+        for (; i < words; ++i) {
+            out[i] = src[i];
+        }
+    }
+
+    constexpr int kSse2Lanes = 2;
+
+    ROW_KERNELS_ENTRY_POINTS(Sse2, __attribute__((target("sse2"))))
+
+    // AVX2: 4 words per vector
+
+    template <RowOp Op>
+    __attribute__((target("avx2"))) __m256i applyOpAvx2(__m256i a, __m256i b) {
+        if constexpr (Op == RowOp::And) return _mm256_and_si256(a, b);
+        else if constexpr (Op == RowOp::Or) return _mm256_or_si256(a, b);
+        else if constexpr (Op == RowOp::AndNot) return _mm256_andnot_si256(b, a);
+        else return _mm256_xor_si256(a, b);
+    }
+
+    template <RowOp Op>
+    __attribute__((target("avx2"))) void combineAvx2Loop(Word* out, const Word* a, const Word* b, int words) {
+        int i = 0;
+        for (; i + 4 <= words; i += 4) {
+            __m256i va = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(a + i));
+            __m256i vb = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(b + i));
+            _mm256_storeu_si256(reinterpret_cast<__m256i*>(out + i), applyOpAvx2<Op>(va, vb));
+        }
+        combineTail<Op>(out, a, b, i, words);
+    }
+
+    template <RowOp Op>
+    __attribute__((target("avx2"))) void combineShiftedAvx2Loop(Word* out, const Word* a, const Word* src, int words, int s) {
+        __m128i right = _mm_cvtsi32_si128(s);
+        __m128i left = _mm_cvtsi32_si128(kWordBits - s);
+        int i = 0;
+        if (s == 0) {
+            for (; i + 4 <= words; i += 4) {
+                __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(src + i));
+                __m256i va = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(a + i));
+                _mm256_storeu_si256(reinterpret_cast<__m256i*>(out + i), applyOpAvx2<Op>(va, v));
+            }
+        } else if (words >= 7) {
+            __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(src));
+            for (; i + 8 <= words + 1; i += 4) {
+                __m256i following = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(src + i + 4));
+                __m256i next = _mm256_blend_epi32(_mm256_permute4x64_epi64(v, 0x39),
+                                                  _mm256_permute4x64_epi64(following, 0x00), 0xC0);
+                __m256i shifted = _mm256_or_si256(_mm256_srl_epi64(v, right), _mm256_sll_epi64(next, left));
+                __m256i va = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(a + i));
+                _mm256_storeu_si256(reinterpret_cast<__m256i*>(out + i), applyOpAvx2<Op>(va, shifted));
+                v = following;
+            }
+        }
+        combineShiftedTail<Op>(out, a, src, i, words, s);
+    }
+
+    __attribute__((target("avx2"))) void minMaxShiftedAvx2Loop(Word* lo, Word* hi, const Word* src, int words, int s) {
+        __m128i right = _mm_cvtsi32_si128(s);
+        __m128i left = _mm_cvtsi32_si128(kWordBits - s);
+        auto update = [&](int i, __m256i v) __attribute__((target("avx2"))) {
+            __m256i* l = reinterpret_cast<__m256i*>(lo + i);
+            __m256i* h = reinterpret_cast<__m256i*>(hi + i);
+            _mm256_storeu_si256(l, _mm256_and_si256(_mm256_loadu_si256(l), v));
+            _mm256_storeu_si256(h, _mm256_or_si256(_mm256_loadu_si256(h), v));
+        };
+        int i = 0;
+        if (s == 0) {
+            for (; i + 4 <= words; i += 4) {
+                update(i, _mm256_loadu_si256(reinterpret_cast<const __m256i*>(src + i)));
+            }
+        } else if (words >= 7) {
+            __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(src));
+            for (; i + 8 <= words + 1; i += 4) {
+                __m256i following = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(src + i + 4));
+                __m256i next = _mm256_blend_epi32(_mm256_permute4x64_epi64(v, 0x39),
+                                                  _mm256_permute4x64_epi64(following, 0x00), 0xC0);
+                update(i, _mm256_or_si256(_mm256_srl_epi64(v, right), _mm256_sll_epi64(next, left)));
+                v = following;
+            }
+        }
+        minMaxShiftedTail(lo, hi, src, i, words, s);
+    }
+
+    __attribute__((target("avx2"))) void fillAvx2(Word* out, Word value, int words) {
+        __m256i v = _mm256_set1_epi64x(static_cast<long long>(value));
+        int i = 0;
+        for (; i + 4 <= words; i += 4) {
+            _mm256_storeu_si256(reinterpret_cast<__m256i*>(out + i), v);
+        }
+        for (; i < words; ++i) {
+            out[i] = value;
+        }
+    }
+
+    __attribute__((target("avx2"))) void copyAvx2(Word* out, const Word* src, int words) {
+        int i = 0;
+        for (; i + 4 <= words; i += 4) {
+            _mm256_storeu_si256(reinterpret_cast<__m256i*>(out + i),
+                                _mm256_loadu_si256(reinterpret_cast<const __m256i*>(src + i)));
+        }
+        for (; i < words; ++i) {
+            out[i] = src[i];
+        }
+    }
+
+    constexpr int kAvx2Lanes = 4;
+
+    ROW_KERNELS_ENTRY_POINTS(Avx2, __attribute__((target("avx2"))))
+
+    // AVX-512F: 8 words per vector, one cache line. GCC reports the
+    // _mm512_undefined_epi32() placeholder inside the intrinsics as
+    // maybe-uninitialized; it is not read.
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wmaybe-uninitialized"
+
+    template <RowOp Op>
+    __attribute__((target("avx512f"))) __m512i applyOpAvx512(__m512i a, __m512i b) {
+        if constexpr (Op == RowOp::And) return _mm512_and_si512(a, b);
+        else if constexpr (Op == RowOp::Or) return _mm512_or_si512(a, b);
+        else if constexpr (Op == RowOp::AndNot) return _mm512_andnot_si512(b, a);
+        else return _mm512_xor_si512(a, b);
+    }
+
+    template <RowOp Op>
+    __attribute__((target("avx512f"))) void combineAvx512Loop(Word* out, const Word* a, const Word* b, int words) {
+        int i = 0;
+        for (; i + 8 <= words; i += 8) {
+            __m512i va = _mm512_loadu_si512(a + i);
+            __m512i vb = _mm512_loadu_si512(b + i);
+            _mm512_storeu_si512(out + i, applyOpAvx512<Op>(va, vb));
+        }
+        combineTail<Op>(out, a, b, i, words);
+    }
+
+    template <RowOp Op>
+    __attribute__((target("avx512f"))) void combineShiftedAvx512Loop(Word* out, const Word* a, const Word* src, int words, int s) {
+        __m128i right = _mm_cvtsi32_si128(s);
+        __m128i left = _mm_cvtsi32_si128(kWordBits - s);
+        int i = 0;
+        if (s == 0) {
+            for (; i + 8 <= words; i += 8) {
+                __m512i v = _mm512_loadu_si512(src + i);
+                _mm512_storeu_si512(out + i, applyOpAvx512<Op>(_mm512_loadu_si512(a + i), v));
+            }
+        } else if (words >= 15) {
+            __m512i v = _mm512_loadu_si512(src);
+            for (; i + 16 <= words + 1; i += 8) {
+                __m512i following = _mm512_loadu_si512(src + i + 8);
+                __m512i next = _mm512_alignr_epi64(following, v, 1);
+                __m512i shifted = _mm512_or_si512(_mm512_srl_epi64(v, right), _mm512_sll_epi64(next, left));
+                _mm512_storeu_si512(out + i, applyOpAvx512<Op>(_mm512_loadu_si512(a + i), shifted));
+                v = following;
+            }
+        }
+        combineShiftedTail<Op>(out, a, src, i, words, s);
+    }
+
+    __attribute__((target("avx512f"))) void minMaxShiftedAvx512Loop(Word* lo, Word* hi, const Word* src, int words, int s) {
+        __m128i right = _mm_cvtsi32_si128(s);
+        __m128i left = _mm_cvtsi32_si128(kWordBits - s);
+        auto update = [&](int i, __m512i v) __attribute__((target("avx512f"))) {
+            _mm512_storeu_si512(lo + i, _mm512_and_si512(_mm512_loadu_si512(lo + i), v));
+            _mm512_storeu_si512(hi + i, _mm512_or_si512(_mm512_loadu_si512(hi + i), v));
+        };
+        int i = 0;
+        if (s == 0) {
+            for (; i + 8 <= words; i += 8) {
+                update(i, _mm512_loadu_si512(src + i));
+            }
+        } else if (words >= 15) {
+            __m512i v = _mm512_loadu_si512(src);
+            for (; i + 16 <= words + 1; i += 8) {
+                __m512i following = _mm512_loadu_si512(src + i + 8);
+                __m512i next = _mm512_alignr_epi64(following, v, 1);
+                update(i, _mm512_or_si512(_mm512_srl_epi64(v, right), _mm512_sll_epi64(next, left)));
+                v = following;
+            }
+        }
+        minMaxShiftedTail(lo, hi, src, i, words, s);
+    }
+
+    __attribute__((target("avx512f"))) void fillAvx512(Word* out, Word value, int words) {
+        __m512i v = _mm512_set1_epi64(static_cast<long long>(value));
+        int i = 0;
+        for (; i + 8 <= words; i += 8) {
+            _mm512_storeu_si512(out + i, v);
+        }
+        for (; i < words; ++i) {
+            out[i] = value;
+        }
+    }
+
+    __attribute__((target("avx512f"))) void copyAvx512(Word* out, const Word* src, int words) {
+        int i = 0;
+        for (; i + 8 <= words; i += 8) {
+            _mm512_storeu_si512(out + i, _mm512_loadu_si512(src + i));
+        }
+        for (; i < words; ++i) {
+            out[i] = src[i];
+        }
+    }
+
+    constexpr int kAvx512Lanes = 8;
+
+    ROW_KERNELS_ENTRY_POINTS(Avx512, __attribute__((target("avx512f"))))
+#pragma GCC diagnostic pop
+#endif
+
+#undef ROW_KERNELS_ENTRY_POINTS
+
+    const RowKernels kScalarKernels{SimdLevel::Scalar, &fillScalar, &copyScalar, &combineScalar, &combineShiftedScalar,
+                                         &minMaxShiftedScalar, kScalarShapeKernels.data()};
+#ifdef ROW_KERNELS_X86
+    const RowKernels kSse2Kernels{SimdLevel::SSE2, &fillSse2, &copySse2, &combineSse2, &combineShiftedSse2,
+                                         &minMaxShiftedSse2, kSse2ShapeKernels.data()};
+    const RowKernels kAvx2Kernels{SimdLevel::AVX2, &fillAvx2, &copyAvx2, &combineAvx2, &combineShiftedAvx2,
+                                         &minMaxShiftedAvx2, kAvx2ShapeKernels.data()};
+    const RowKernels kAvx512Kernels{SimdLevel::AVX512, &fillAvx512, &copyAvx512, &combineAvx512, &combineShiftedAvx512,
+                                         &minMaxShiftedAvx512, kAvx512ShapeKernels.data()};
+#endif
+
+    const RowKernels* kernelsFor(SimdLevel level) {
+#ifdef ROW_KERNELS_X86
+        switch (level) {
+            case SimdLevel::AVX512: return &kAvx512Kernels;
+            case SimdLevel::AVX2: return &kAvx2Kernels;
+            case SimdLevel::SSE2: return &kSse2Kernels;
+            case SimdLevel::Scalar: break;
+        }
+#else
+        (void)level;
+#endif
+        return &kScalarKernels;
+    }
+
+    std::atomic<const RowKernels*>& activeKernels() {
+        static std::atomic<const RowKernels*> active{kernelsFor(detectSimdLevel())};
+        return active;
+    }
+}
+
+SimdLevel detectSimdLevel() {
+#ifdef ROW_KERNELS_X86
+    // __builtin_cpu_supports also checks that the OS saves the vector state
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx512f")) return SimdLevel::AVX512;
+    if (__builtin_cpu_supports("avx2")) return SimdLevel::AVX2;
+    if (__builtin_cpu_supports("sse2")) return SimdLevel::SSE2;
+#endif
+    return SimdLevel::Scalar;
+}
+
+const RowKernels& rowKernels() {
+    return *activeKernels().load(std::memory_order_relaxed);
+}
+
+SimdLevel setSimdLevel(SimdLevel level) {
+    SimdLevel supported = detectSimdLevel();
+    if (static_cast<int>(level) > static_cast<int>(supported)) {
+        level = supported;
+    }
+    activeKernels().store(kernelsFor(level), std::memory_order_relaxed);
+    return level;
+}
+
+const char* simdLevelName(SimdLevel level) {
+    switch (level) {
+        case SimdLevel::Scalar: return "Scalar";
+        case SimdLevel::SSE2: return "SSE2";
+        case SimdLevel::AVX2: return "AVX2";
+        case SimdLevel::AVX512: return "AVX512";
+    }
+    return "Unknown";
+}
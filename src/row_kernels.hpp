@@ -0,0 +1,128 @@
+#ifndef ROW_KERNELS_HPP
+#define ROW_KERNELS_HPP
+
+#include "binary_image.hpp"
+
+/**
+ * @brief Instruction set used by the bit-packed row kernels.
+ */
+enum class SimdLevel {
+    Scalar,  ///< Plain 64-bit word operations
+    SSE2,    ///< 128-bit vectors
+    AVX2,    ///< 256-bit vectors
+    AVX512   ///< 512-bit vectors (AVX-512F)
+};
+
+/**
+ * @brief Word-wise boolean operation applied by the row kernels.
+ */
+enum class RowOp {
+    And,     ///< a & b
+    Or,      ///< a | b
+    AndNot,  ///< a & ~b
+    Xor      ///< a ^ b
+};
+
+/**
+ * @brief Structuring elements with unrolled kernels, see morphology_kernels.hpp.
+ */
+enum class FixedShape {
+    Square3, Square5, Square7,  ///< Full N x N squares
+    Cross3, Cross5, Cross7,     ///< Plus shapes of width N
+    Disk2, Disk3                ///< Digital disks of radius R (radius 1 is Cross3)
+};
+
+constexpr int kFixedShapeCount = 8;
+
+/**
+ * @brief Unrolled erosion/dilation row kernels of one fixed shape.
+ *
+ * rows holds 2 * reach + 1 source row pointers, rows[k] being the row at
+ * dy = k - reach, each readable reach pixels and one word beyond both ends.
+ */
+struct ShapeRowKernels {
+    int reach;
+    void (*erode)(const BinaryImage::Word* const* rows, int words, BinaryImage::Word* out);
+    void (*dilate)(const BinaryImage::Word* const* rows, int words, BinaryImage::Word* out);
+    void (*minMax)(const BinaryImage::Word* const* rows, int words, BinaryImage::Word* lo,
+                   BinaryImage::Word* hi);
+};
+
+/**
+ * @brief Table of row kernels for one instruction set.
+ *
+ * All variants produce bit-identical results; they only differ in how
+ * many words each instruction processes. Rows that a kernel reads right
+ * after they were written should be written by the same table: loads that
+ * straddle narrower stores cannot be forwarded and stall.
+ */
+struct RowKernels {
+    SimdLevel level;
+
+    /**
+     * @brief out[i] = value for i in [0, words).
+     */
+    void (*fill)(BinaryImage::Word* out, BinaryImage::Word value, int words);
+
+    /**
+     * @brief out[i] = src[i] for i in [0, words); the ranges must not overlap.
+     */
+    void (*copy)(BinaryImage::Word* out, const BinaryImage::Word* src, int words);
+
+    /**
+     * @brief out[i] = a[i] op b[i] for i in [0, words).
+     *
+     * out may alias a or b.
+     */
+    void (*combine)(RowOp op, BinaryImage::Word* out, const BinaryImage::Word* a,
+                    const BinaryImage::Word* b, int words);
+
+    /**
+     * @brief out[i] = a[i] op (row shifted so that bit x holds pixel x + dx).
+     *
+     * Reads row words from floor(dx / 64) to floor(dx / 64) + words, so the
+     * row must be readable one word past the shifted range. out may alias a.
+     */
+    void (*combineShifted)(RowOp op, BinaryImage::Word* out, const BinaryImage::Word* a,
+                           const BinaryImage::Word* row, int words, int dx);
+
+    /**
+     * @brief lo[i] &= shifted row, hi[i] |= shifted row, in one pass.
+     *
+     * Same shift and readable range as combineShifted; used to compute
+     * erosion and dilation together.
+     */
+    void (*minMaxShifted)(BinaryImage::Word* lo, BinaryImage::Word* hi,
+                          const BinaryImage::Word* row, int words, int dx);
+
+    /**
+     * @brief Kernels of every fixed shape, indexed by FixedShape.
+     */
+    const ShapeRowKernels* shapes;
+};
+
+/**
+ * @brief Kernels for the active instruction set.
+ *
+ * The first call selects the widest level the CPU supports.
+ */
+const RowKernels& rowKernels();
+
+/**
+ * @brief Widest instruction set supported by this CPU and build.
+ */
+SimdLevel detectSimdLevel();
+
+/**
+ * @brief Override the active instruction set, e.g. to compare variants.
+ * @param level Requested level, lowered to detectSimdLevel() if wider
+ * @return The level actually selected
+ */
+SimdLevel setSimdLevel(SimdLevel level);
+
+/**
+ * @brief Human-readable name of a level ("Scalar", "SSE2", ...).
+ */
+const char* simdLevelName(SimdLevel level);
+
+#endif // ROW_KERNELS_HPP
@@ -0,0 +1,47 @@
+#ifndef STEP_BUDGET_HPP
+#define STEP_BUDGET_HPP
+
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+
+/**
+ * @brief Run batches of steps until a time budget is used up.
+ * @param microseconds Budget; at least one step runs even if it is 0
+ * @param step_batch Callable taking a step count n and returning the
+ *        steps actually taken, fewer than n only once the work is done
+ * @return Total steps taken
+ *
+ * Reading the clock costs about as much as a cheap step, so it is read
+ * once per batch. Each batch is sized from the step rate measured so far
+ * to take half of the remaining time, which ends close to the deadline
+ * without overshooting it by more than about one step.
+ */
+template <typename StepBatch>
+size_t runForBudget(int64_t microseconds, StepBatch step_batch) {
+    using Clock = std::chrono::steady_clock;
+    Clock::time_point start = Clock::now();
+    Clock::time_point deadline = start + std::chrono::microseconds(microseconds);
+    size_t done = 0;
+    size_t batch = 1;
+    while (true) {
+        size_t taken = step_batch(batch);
+        done += taken;
+        Clock::time_point now = Clock::now();
+        if (taken < batch || now >= deadline) {
+            return done;
+        }
+
+        double elapsed = std::chrono::duration<double>(now - start).count();
+        double remaining = std::chrono::duration<double>(deadline - now).count();
+        if (elapsed <= 0.0) {
+            batch *= 2;
+            continue;
+        }
+        double steps = remaining * done / elapsed / 2.0;
+        batch = std::max<size_t>(1, static_cast<size_t>(std::min(steps, 1e9)));
+    }
+}
+
+#endif // STEP_BUDGET_HPP
@@ -0,0 +1,64 @@
+#ifndef THREAD_POOL_HPP
+#define THREAD_POOL_HPP
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/**
+ * @brief Fixed-size pool of worker threads for data-parallel loops.
+ *
+ * The calling thread takes part in every parallelFor, so a pool of N
+ * threads owns N - 1 workers. Tasks are handed out dynamically; callers
+ * that need deterministic results must make each task independent of
+ * which thread runs it.
+ */
+class ThreadPool {
+public:
+    /**
+     * @brief Create a pool.
+     * @param thread_count Total threads including the caller
+     *        (<= 0: one per hardware thread)
+     */
+    explicit ThreadPool(int thread_count = 0);
+    ~ThreadPool();
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    /**
+     * @brief Number of threads that run tasks, including the caller.
+     */
+    int threadCount() const { return static_cast<int>(workers_.size()) + 1; }
+
+    /**
+     * @brief Run task(i) for every i in [0, count) and wait for all of them.
+     *
+     * Calls from different threads are serialized.
+     */
+    void parallelFor(int count, const std::function<void(int)>& task);
+
+private:
+    void workerLoop();
+    void runTasks();
+
+    std::vector<std::thread> workers_;
+
+    std::mutex call_mutex_;   // Serializes parallelFor calls
+    std::mutex mutex_;        // Guards the job fields below
+    std::condition_variable wake_;
+    std::condition_variable done_;
+
+    const std::function<void(int)>* task_ = nullptr;
+    int count_ = 0;
+    std::atomic<int> next_{0};
+    int busy_ = 0;             // Workers still inside the current job
+    uint64_t generation_ = 0;  // Bumped for every new job
+    bool stopping_ = false;
+};
+
+#endif // THREAD_POOL_HPP
@@ -0,0 +1,67 @@
+#include "tile_map.hpp"
+#include <algorithm>
+
+TileMap::TileMap(const BinaryImageView& image) {
+    assign(image);
+}
+
+void TileMap::assign(const BinaryImageView& image) {
+    tiles_x_ = image.rowWords();
+    tiles_y_ = (image.height() + kTileSize - 1) / kTileSize;
+    uniform_count_ = 0;
+    states_.resize(static_cast<size_t>(tiles_x_) * tiles_y_);
+    set_sums_.assign(static_cast<size_t>(tiles_x_ + 1) * (tiles_y_ + 1), 0);
+    clear_sums_.assign(static_cast<size_t>(tiles_x_ + 1) * (tiles_y_ + 1), 0);
+    if (tiles_x_ == 0 || tiles_y_ == 0) {
+        return;
+    }
+
+    // Per tile column of the current tile row: whether a 1 or a 0 was seen
+    using Word = BinaryImage::Word;
+    std::vector<Word> any_set(tiles_x_);
+    std::vector<Word> any_clear(tiles_x_);
+    std::vector<Word> buffer(tiles_x_);
+    Word tail = image.rowTailMask();
+    for (int ty = 0; ty < tiles_y_; ++ty) {
+        std::fill(any_set.begin(), any_set.end(), 0);
+        std::fill(any_clear.begin(), any_clear.end(), 0);
+        int y_end = std::min(image.height(), (ty + 1) * kTileSize);
+        for (int y = ty * kTileSize; y < y_end; ++y) {
+            const Word* row = image.alignedRow(y, buffer.data());
+            for (int tx = 0; tx + 1 < tiles_x_; ++tx) {
+                any_set[tx] |= row[tx];
+                any_clear[tx] |= ~row[tx];
+            }
+            any_set[tiles_x_ - 1] |= row[tiles_x_ - 1] & tail;
+            any_clear[tiles_x_ - 1] |= ~row[tiles_x_ - 1] & tail;
+        }
+
+        for (int tx = 0; tx < tiles_x_; ++tx) {
+            bool set = any_set[tx] != 0;
+            bool clear = any_clear[tx] != 0;
+            TileState state = set && clear ? TileState::Mixed : set ? TileState::Full : TileState::Empty;
+            states_[static_cast<size_t>(ty) * tiles_x_ + tx] = state;
+            uniform_count_ += state != TileState::Mixed;
+
+            size_t at = static_cast<size_t>(ty + 1) * (tiles_x_ + 1) + tx + 1;
+            set_sums_[at] = sumAt(set_sums_, tx + 1, ty) + sumAt(set_sums_, tx, ty + 1) -
+                            sumAt(set_sums_, tx, ty) + set;
+            clear_sums_[at] = sumAt(clear_sums_, tx + 1, ty) + sumAt(clear_sums_, tx, ty + 1) -
+                              sumAt(clear_sums_, tx, ty) + clear;
+        }
+    }
+}
+
+TileState TileMap::blockState(int tx0, int ty0, int tx1, int ty1) const {
+    auto count = [&](const std::vector<int>& sums) {
+        return sumAt(sums, tx1 + 1, ty1 + 1) - sumAt(sums, tx0, ty1 + 1) -
+               sumAt(sums, tx1 + 1, ty0) + sumAt(sums, tx0, ty0);
+    };
+    if (count(set_sums_) == 0) {
+        return TileState::Empty;
+    }
+    if (count(clear_sums_) == 0) {
+        return TileState::Full;
+    }
+    return TileState::Mixed;
+}
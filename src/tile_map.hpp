@@ -0,0 +1,84 @@
+#ifndef TILE_MAP_HPP
+#define TILE_MAP_HPP
+
+#include "binary_image.hpp"
+#include <cstdint>
+#include <vector>
+
+/**
+ * @brief Content of a tile or of a block of tiles.
+ */
+enum class TileState : uint8_t {
+    Empty,  ///< Every pixel is 0
+    Full,   ///< Every pixel is 1
+    Mixed   ///< Both values occur
+};
+
+/**
+ * @brief Occupancy summary of an image in square tiles.
+ *
+ * Tiles are kTileSize pixels on a side, so tile column tx covers exactly
+ * the packed word tx of every row. Tiles on the right and bottom edges
+ * only summarize the pixels inside the image.
+ *
+ * Building the map reads every word once. Afterwards the state of any
+ * block of tiles is answered in O(1) from prefix counts, which lets
+ * kernels resolve regions far from any edge without reading their pixels.
+ */
+class TileMap {
+public:
+    static constexpr int kTileSize = BinaryImage::kWordBits;
+
+    /**
+     * @brief Empty map of an image without pixels.
+     */
+    TileMap() = default;
+
+    /**
+     * @brief Summarize an image.
+     */
+    explicit TileMap(const BinaryImageView& image);
+
+    /**
+     * @brief Summarize another image, reusing the storage of the map.
+     */
+    void assign(const BinaryImageView& image);
+
+    int tilesX() const { return tiles_x_; }
+    int tilesY() const { return tiles_y_; }
+
+    /**
+     * @brief State of tile (tx, ty), not bounds checked.
+     */
+    TileState state(int tx, int ty) const {
+        return states_[static_cast<size_t>(ty) * tiles_x_ + tx];
+    }
+
+    /**
+     * @brief State of the tiles [tx0, tx1] x [ty0, ty1] taken together.
+     * @return Empty or Full if every tile in the block is, Mixed otherwise
+     *
+     * The block must lie inside the map and hold at least one tile.
+     */
+    TileState blockState(int tx0, int ty0, int tx1, int ty1) const;
+
+    /**
+     * @brief Number of tiles that are Empty or Full.
+     */
+    int uniformCount() const { return uniform_count_; }
+
+private:
+    // Entry (tx, ty) counts the tiles above and left of tile (tx, ty)
+    int sumAt(const std::vector<int>& sums, int tx, int ty) const {
+        return sums[static_cast<size_t>(ty) * (tiles_x_ + 1) + tx];
+    }
+
+    int tiles_x_ = 0;
+    int tiles_y_ = 0;
+    int uniform_count_ = 0;
+    std::vector<TileState> states_;  // Row-major, tiles_x_ per tile row
+    std::vector<int> set_sums_;      // Prefix counts of tiles holding a 1
+    std::vector<int> clear_sums_;    // Prefix counts of tiles holding a 0
+};
+
+#endif // TILE_MAP_HPP
@@ -1,4 +1,5 @@
 #include "visualizer.hpp"
+#include "row_kernels.hpp"
 #include "imgui.h"
 #include "imgui_impl_sdl2.h"
 #include "imgui_impl_opengl3.h"
@@ -118,7 +119,8 @@ void Visualizer::renderGrids(const BinaryImage& original,
     
     // Determine operation type for coloring
     MorphOperation op = morph.getOperation();
-    const char* op_labels[] = {"EROSION", "DILATION", "INNER EDGE", "OUTER EDGE", "GRADIENT"};
+    const char* op_labels[] = {"EROSION", "DILATION", "INNER EDGE", "OUTER EDGE", "GRADIENT",
+                               "OPENING", "CLOSING", "WHITE TOP-HAT", "BLACK TOP-HAT"};
     const char* op_label = op_labels[static_cast<int>(op)];
     
     // Draw panel labels
@@ -200,10 +202,16 @@ void Visualizer::renderGrids(const BinaryImage& original,
                             case MorphOperation::Dilation:
                                 color = IM_COL32(100, 150, 255, 255);  // Blue - dilated
                                 break;
+                            case MorphOperation::Opening:
+                            case MorphOperation::Closing:
+                                color = IM_COL32(0, 200, 200, 255);    // Teal - filtered shape
+                                break;
                             case MorphOperation::InnerBoundary:
                             case MorphOperation::OuterBoundary:
                             case MorphOperation::Gradient:
-                                color = IM_COL32(255, 200, 0, 255);    // Yellow - edge
+                            case MorphOperation::WhiteTopHat:
+                            case MorphOperation::BlackTopHat:
+                                color = IM_COL32(255, 200, 0, 255);    // Yellow - edge/detail
                                 break;
                         }
                     } else {
@@ -212,11 +220,15 @@ void Visualizer::renderGrids(const BinaryImage& original,
                                 color = IM_COL32(100, 50, 50, 255);    // Dark red - eroded
                                 break;
                             case MorphOperation::Dilation:
+                            case MorphOperation::Opening:
+                            case MorphOperation::Closing:
                                 color = IM_COL32(40, 40, 50, 255);     // Dark blue
                                 break;
                             case MorphOperation::InnerBoundary:
                             case MorphOperation::OuterBoundary:
                             case MorphOperation::Gradient:
+                            case MorphOperation::WhiteTopHat:
+                            case MorphOperation::BlackTopHat:
                                 color = IM_COL32(35, 35, 35, 255);     // Dark - not edge
                                 break;
                         }
@@ -253,7 +265,8 @@ void Visualizer::renderImGui(const BinaryImage& original, BinaryImage& result) {
     
     // Operation selection
     ImGui::SeparatorText("Operation");
-    const char* operations[] = {"Erosion", "Dilation", "Inner Boundary", "Outer Boundary", "Gradient"};
+    const char* operations[] = {"Erosion", "Dilation", "Inner Boundary", "Outer Boundary", "Gradient",
+                                "Opening", "Closing", "White Top-Hat", "Black Top-Hat"};
     if (ImGui::Combo("Type", &controls_.selected_operation, operations, IM_ARRAYSIZE(operations))) {
         controls_.needs_regenerate = true;
     }
@@ -263,7 +276,11 @@ void Visualizer::renderImGui(const BinaryImage& original, BinaryImage& result) {
         "Expands foreground (ANY neighbor = 1)",
         "Original - Eroded (internal edge)",
         "Dilated - Original (external edge)",
-        "Dilated XOR Eroded (full edge)"
+        "Dilated XOR Eroded (full edge)",
+        "Erode then dilate (removes small specks)",
+        "Dilate then erode (fills small holes)",
+        "Original - Opening (small bright detail)",
+        "Closing - Original (small holes and gaps)"
     };
     ImGui::TextWrapped("%s", op_desc[controls_.selected_operation]);
     
@@ -318,11 +335,17 @@ void Visualizer::renderImGui(const BinaryImage& original, BinaryImage& result) {
     if (ImGui::Checkbox("Cross Shape SE", &controls_.se_is_cross)) {
         controls_.needs_regenerate = true;
     }
+    if (ImGui::SliderInt("Iterations", &controls_.iterations, 1, 4)) {
+        controls_.needs_regenerate = true;
+    }
     
     // Animation controls
     ImGui::SeparatorText("Animation");
     ImGui::SliderInt("Speed (ms)", &controls_.animation_speed, 5, 200);
     anim_state_.speed_ms = controls_.animation_speed;
+    ImGui::SliderInt("Budget (ms/frame)", &controls_.frame_budget_ms, 0, 16);
+    anim_state_.frame_budget_ms = controls_.frame_budget_ms;
+    ImGui::TextWrapped("Budget 0: one pixel per tick\nBudget > 0: as many pixels as fit per frame");
     
     if (anim_state_.paused) {
         if (ImGui::Button("Play", ImVec2(80, 30))) {
@@ -340,13 +363,8 @@ void Visualizer::renderImGui(const BinaryImage& original, BinaryImage& result) {
     ImGui::SameLine();
     if (ImGui::Button("Step", ImVec2(80, 30))) {
         if (!anim_state_.completed) {
-            anim_state_.last_step_time = 0;
-            Uint32 saved_speed = anim_state_.speed_ms;
-            anim_state_.speed_ms = 0;
-            anim_state_.paused = false;
-            stepAnimation(anim_state_, *current_image_, *result_image_, *morphology_);
-            anim_state_.speed_ms = saved_speed;
-            anim_state_.paused = true;
+            stepper_->step();
+            syncAnimation(anim_state_, *stepper_);
         }
     }
     
@@ -362,6 +380,7 @@ void Visualizer::renderImGui(const BinaryImage& original, BinaryImage& result) {
     ImGui::Text("Position: (%d, %d)", anim_state_.current_x, anim_state_.current_y);
     const char* bound_name = boundaries[controls_.selected_boundary];
     ImGui::Text("Boundary: %s", bound_name);
+    ImGui::Text("Row kernels: %s", simdLevelName(rowKernels().level));
     
     // Legend (dynamic based on operation)
     ImGui::SeparatorText("Legend");
@@ -377,7 +396,10 @@ void Visualizer::renderImGui(const BinaryImage& original, BinaryImage& result) {
     } else if (controls_.selected_operation == 1) {  // Dilation
         ImGui::TextColored(ImVec4(0.4f, 0.6f, 1, 1), "Blue: Dilated");
         ImGui::TextColored(ImVec4(0.15f, 0.15f, 0.2f, 1), "Dark: Not expanded");
-    } else {  // Boundary operations
+    } else if (controls_.selected_operation == 5 || controls_.selected_operation == 6) {  // Opening/Closing
+        ImGui::TextColored(ImVec4(0, 0.8f, 0.8f, 1), "Teal: Filtered shape");
+        ImGui::TextColored(ImVec4(0.15f, 0.15f, 0.2f, 1), "Dark: Background");
+    } else {  // Boundary and top-hat operations
         ImGui::TextColored(ImVec4(1, 0.8f, 0, 1), "Yellow: Edge/Boundary");
         ImGui::TextColored(ImVec4(0.15f, 0.15f, 0.15f, 1), "Dark: Not edge");
     }
@@ -388,31 +410,29 @@ void Visualizer::renderImGui(const BinaryImage& original, BinaryImage& result) {
     ImGui_ImplOpenGL3_RenderDrawData(ImGui::GetDrawData());
 }
 
-void Visualizer::stepAnimation(AnimationState& state, 
-                               const BinaryImage& original,
-                               BinaryImage& result,
-                               const Morphology& morph) {
+void Visualizer::stepAnimation(AnimationState& state, MorphologyStepper& stepper) {
     if (state.completed || state.paused) {
         return;
     }
 
-    Uint32 current_time = SDL_GetTicks();
-    if (current_time - state.last_step_time < static_cast<Uint32>(state.speed_ms)) {
-        return;
-    }
-    state.last_step_time = current_time;
-
-    bool survives = morph.checkPixel(original, state.current_x, state.current_y);
-    result.set(state.current_x, state.current_y, survives);
-
-    state.current_x++;
-    if (state.current_x >= original.width()) {
-        state.current_x = 0;
-        state.current_y++;
-        if (state.current_y >= original.height()) {
-            state.completed = true;
+    if (state.frame_budget_ms > 0) {
+        // Large maps: fill the frame budget instead of waiting for ticks
+        stepper.stepFor(static_cast<int64_t>(state.frame_budget_ms) * 1000);
+    } else {
+        Uint32 current_time = SDL_GetTicks();
+        if (current_time - state.last_step_time < static_cast<Uint32>(state.speed_ms)) {
+            return;
         }
+        state.last_step_time = current_time;
+        stepper.step();
     }
+    syncAnimation(state, stepper);
+}
+
+void Visualizer::syncAnimation(AnimationState& state, const MorphologyStepper& stepper) {
+    state.current_x = stepper.currentX();
+    state.current_y = stepper.currentY();
+    state.completed = stepper.isComplete();
 }
 
 void Visualizer::resetAnimation() {
@@ -423,6 +443,9 @@ void Visualizer::resetAnimation() {
     if (result_image_) {
         result_image_->clear();
     }
+    if (stepper_) {
+        stepper_->reset();
+    }
 }
 
 bool Visualizer::handleEvents() {
@@ -466,11 +489,7 @@ bool Visualizer::handleEvents() {
     return true;
 }
 
-void Visualizer::run(std::function<BinaryImage(const UIControls&)> createImageFunc) {
-    current_image_ = std::make_unique<BinaryImage>(createImageFunc(controls_));
-    result_image_ = std::make_unique<BinaryImage>(current_image_->width(), current_image_->height(), false);
-    
-    // Create morphology processor with current settings
+void Visualizer::createMorphology() {
     StructuringElement se = controls_.se_is_cross ? 
         StructuringElement::createCross(controls_.se_size) :
         StructuringElement::createSquare(controls_.se_size);
@@ -480,10 +499,23 @@ void Visualizer::run(std::function<BinaryImage(const UIControls&)> createImageFu
     BoundaryMode boundary = static_cast<BoundaryMode>(controls_.selected_boundary);
     
     morphology_ = std::make_unique<Morphology>(se, op, boundary);
+    morphology_->setIterations(controls_.iterations);
+    
+    // The stepper references the processor and both images, so it is
+    // rebuilt whenever any of them is replaced
+    stepper_ = std::make_unique<MorphologyStepper>(*morphology_, *current_image_, *result_image_);
+}
+
+void Visualizer::run(std::function<BinaryImage(const UIControls&)> createImageFunc) {
+    current_image_ = std::make_unique<BinaryImage>(createImageFunc(controls_));
+    result_image_ = std::make_unique<BinaryImage>(current_image_->width(), current_image_->height(), false);
+    
+    // Create morphology processor with current settings
+    createMorphology();
 
     std::cout << "\n=== Morphological Operations - Interactive Demo ===\n";
     std::cout << "Use the ImGui control panel to:\n";
-    std::cout << "  - Switch between Erosion and Dilation\n";
+    std::cout << "  - Switch between Erosion, Dilation, Opening, Closing and more\n";
     std::cout << "  - Change boundary handling mode\n";
     std::cout << "  - Adjust grid size and shape\n";
     std::cout << "  - Control animation speed\n\n";
@@ -523,21 +555,13 @@ void Visualizer::run(std::function<BinaryImage(const UIControls&)> createImageFu
             image_height_ = current_image_->height();
             result_image_ = std::make_unique<BinaryImage>(image_width_, image_height_, false);
             
-            StructuringElement se = controls_.se_is_cross ? 
-                StructuringElement::createCross(controls_.se_size) :
-                StructuringElement::createSquare(controls_.se_size);
-            
-            MorphOperation op = static_cast<MorphOperation>(controls_.selected_operation);
-            
-            BoundaryMode boundary = static_cast<BoundaryMode>(controls_.selected_boundary);
-            
-            morphology_ = std::make_unique<Morphology>(se, op, boundary);
+            createMorphology();
             
             resetAnimation();
         }
         
         if (!anim_state_.paused && !anim_state_.completed) {
-            stepAnimation(anim_state_, *current_image_, *result_image_, *morphology_);
+            stepAnimation(anim_state_, *stepper_);
         }
 
         int display_w, display_h;
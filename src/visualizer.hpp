@@ -17,6 +17,7 @@ struct AnimationState {
     bool paused = true;
     bool completed = false;
     int speed_ms = 50;
+    int frame_budget_ms = 0;  // > 0: step for this long every frame
     Uint32 last_step_time = 0;
 };
 
@@ -37,9 +38,11 @@ struct UIControls {
     // Structuring element
     int se_size = 3;
     bool se_is_cross = false;
+    int iterations = 1;  // Repetitions of each erosion/dilation
     
     // Animation speed
     int animation_speed = 50;
+    int frame_budget_ms = 0;  // 0: one pixel per speed tick
     
     // Shape selection
     int selected_shape = 4;  // 0=rect, 1=cross, 2=lshape, 3=circle, 4=noise
@@ -77,11 +80,10 @@ private:
                      const Morphology& morph);
     void drawPixelGL(float x, float y, float size, float r, float g, float b);
 
-    void stepAnimation(AnimationState& state, 
-                       const BinaryImage& original,
-                       BinaryImage& result,
-                       const Morphology& morph);
+    void stepAnimation(AnimationState& state, MorphologyStepper& stepper);
+    void syncAnimation(AnimationState& state, const MorphologyStepper& stepper);
     void resetAnimation();
+    void createMorphology();
     bool handleEvents();
 
     // SDL/OpenGL resources
@@ -106,6 +108,7 @@ private:
     std::unique_ptr<BinaryImage> current_image_;
     std::unique_ptr<BinaryImage> result_image_;
     std::unique_ptr<Morphology> morphology_;
+    std::unique_ptr<MorphologyStepper> stepper_;
 };
 
 #endif // VISUALIZER_HPP
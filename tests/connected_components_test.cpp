@@ -0,0 +1,159 @@
+// Labels and statistics must match a plain BFS labeling, numbered in
+// raster order of each component's first pixel, for any thread count.
+
+#include "connected_components.hpp"
+#include <algorithm>
+#include <cstdio>
+#include <deque>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace {
+    // Components that reach across every strip seam: vertical bars joined
+    // only along the bottom row, and a checkerboard joined only diagonally
+    BinaryImage comb(int width, int height) {
+        BinaryImage image(width, height, false);
+        for (int y = 0; y < height; ++y) {
+            for (int x = 0; x < width; ++x) {
+                image.set(x, y, x % 2 == 0 || y == height - 1);
+            }
+        }
+        return image;
+    }
+
+    BinaryImage checkerboard(int width, int height) {
+        BinaryImage image(width, height, false);
+        for (int y = 0; y < height; ++y) {
+            for (int x = 0; x < width; ++x) {
+                image.set(x, y, (x + y) % 2 == 0);
+            }
+        }
+        return image;
+    }
+
+    struct Reference {
+        std::vector<int32_t> labels;
+        std::vector<ComponentStats> stats;
+    };
+
+    // Label each component with a BFS from its first pixel in raster order
+    Reference bfsLabels(const BinaryImage& image, Connectivity connectivity, bool value) {
+        int w = image.width();
+        int h = image.height();
+        Reference ref;
+        ref.labels.assign(static_cast<size_t>(w) * h, 0);
+        for (int y = 0; y < h; ++y) {
+            for (int x = 0; x < w; ++x) {
+                if (image.get(x, y) != value || ref.labels[static_cast<size_t>(y) * w + x] != 0) {
+                    continue;
+                }
+                int32_t label = static_cast<int32_t>(ref.stats.size()) + 1;
+                ComponentStats stats;
+                stats.min_x = stats.max_x = x;
+                stats.min_y = stats.max_y = y;
+                int64_t sum_x = 0;
+                int64_t sum_y = 0;
+                std::deque<std::pair<int, int>> queue{{x, y}};
+                ref.labels[static_cast<size_t>(y) * w + x] = label;
+                while (!queue.empty()) {
+                    auto [px, py] = queue.front();
+                    queue.pop_front();
+                    stats.area++;
+                    sum_x += px;
+                    sum_y += py;
+                    stats.min_x = std::min(stats.min_x, px);
+                    stats.max_x = std::max(stats.max_x, px);
+                    stats.min_y = std::min(stats.min_y, py);
+                    stats.max_y = std::max(stats.max_y, py);
+                    for (int dy = -1; dy <= 1; ++dy) {
+                        for (int dx = -1; dx <= 1; ++dx) {
+                            int nx = px + dx;
+                            int ny = py + dy;
+                            bool diagonal = dx != 0 && dy != 0;
+                            if ((dx == 0 && dy == 0) || (diagonal && connectivity == Connectivity::Four) ||
+                                nx < 0 || nx >= w || ny < 0 || ny >= h || image.get(nx, ny) != value) {
+                                continue;
+                            }
+                            int32_t& neighbor = ref.labels[static_cast<size_t>(ny) * w + nx];
+                            if (neighbor == 0) {
+                                neighbor = label;
+                                queue.emplace_back(nx, ny);
+                            }
+                        }
+                    }
+                }
+                stats.centroid_x = static_cast<double>(sum_x) / stats.area;
+                stats.centroid_y = static_cast<double>(sum_y) / stats.area;
+                ref.stats.push_back(stats);
+            }
+        }
+        return ref;
+    }
+
+    bool sameStats(const ComponentStats& a, const ComponentStats& b) {
+        return a.area == b.area && a.min_x == b.min_x && a.min_y == b.min_y && a.max_x == b.max_x &&
+               a.max_y == b.max_y && a.centroid_x == b.centroid_x && a.centroid_y == b.centroid_y;
+    }
+
+    bool matches(const ComponentLabels& labels, const Reference& ref) {
+        if (labels.count() != static_cast<int>(ref.stats.size())) {
+            return false;
+        }
+        for (int y = 0; y < labels.height(); ++y) {
+            for (int x = 0; x < labels.width(); ++x) {
+                if (labels.get(x, y) != ref.labels[static_cast<size_t>(y) * labels.width() + x]) {
+                    return false;
+                }
+            }
+        }
+        for (size_t i = 0; i < ref.stats.size(); ++i) {
+            if (!sameStats(labels.stats()[i], ref.stats[i])) {
+                return false;
+            }
+        }
+        return true;
+    }
+}
+
+int main() {
+    struct Case {
+        std::string name;
+        BinaryImage image;
+    };
+    std::vector<Case> images;
+    for (int seed = 0; seed < 3; ++seed) {
+        images.push_back({"noise " + std::to_string(seed),
+                          BinaryImage::createNoise(131 + 40 * seed, 300 - 50 * seed, 0.1f, 0.5f, seed)});
+    }
+    images.push_back({"comb", comb(67, 257)});
+    images.push_back({"checkerboard", checkerboard(70, 199)});
+    images.push_back({"empty", BinaryImage(65, 130, false)});
+
+    int failures = 0;
+    int cases = 0;
+    for (const Case& c : images) {
+        for (Connectivity connectivity : {Connectivity::Four, Connectivity::Eight}) {
+            for (bool value : {true, false}) {
+                Reference ref = bfsLabels(c.image, connectivity, value);
+
+                // One object relabels for every thread count, as a stream
+                // of frames would
+                ComponentLabels labels;
+                for (int threads : {1, 2, 3, 5, 8}) {
+                    labels.setThreadCount(threads);
+                    labels.relabel(c.image, connectivity, value);
+                    ++cases;
+                    if (!matches(labels, ref)) {
+                        std::printf("FAIL %s, %s-connected, value %d, %d threads\n", c.name.c_str(),
+                                    connectivity == Connectivity::Four ? "4" : "8", value, threads);
+                        ++failures;
+                    }
+                }
+            }
+        }
+    }
+
+    std::printf("%d/%d labelings match the BFS reference\n", cases - failures, cases);
+    return failures == 0 ? 0 : 1;
+}
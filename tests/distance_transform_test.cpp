@@ -0,0 +1,94 @@
+// The distance field must equal a brute-force search for the nearest
+// feature, with the pixels outside the image given by the boundary mode.
+
+#include "distance_transform.hpp"
+#include <algorithm>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+namespace {
+    const BoundaryMode kBoundaries[] = {
+        BoundaryMode::Zero,
+        BoundaryMode::One,
+        BoundaryMode::Extend,
+        BoundaryMode::Wrap
+    };
+
+    bool pixel(const BinaryImage& image, BoundaryMode boundary, int x, int y) {
+        int w = image.width();
+        int h = image.height();
+        if (x >= 0 && x < w && y >= 0 && y < h) {
+            return image.get(x, y);
+        }
+        switch (boundary) {
+            case BoundaryMode::Zero:
+                return false;
+            case BoundaryMode::One:
+                return true;
+            case BoundaryMode::Extend:
+                return image.get(std::clamp(x, 0, w - 1), std::clamp(y, 0, h - 1));
+            case BoundaryMode::Wrap:
+                return image.get(((x % w) + w) % w, ((y % h) + h) % h);
+        }
+        return false;
+    }
+
+    // Every feature within one image size of the pixel; the nearest one is
+    // always that close, even across a wrapped edge
+    uint32_t bruteForce(const BinaryImage& image, BoundaryMode boundary, bool feature_value, int x, int y) {
+        int reach = std::max(image.width(), image.height());
+        uint64_t best = DistanceField::kInfinite;
+        for (int qy = -reach; qy < image.height() + reach; ++qy) {
+            for (int qx = -reach; qx < image.width() + reach; ++qx) {
+                if (pixel(image, boundary, qx, qy) == feature_value) {
+                    int64_t dx = qx - x;
+                    int64_t dy = qy - y;
+                    best = std::min<uint64_t>(best, static_cast<uint64_t>(dx * dx + dy * dy));
+                }
+            }
+        }
+        return static_cast<uint32_t>(best);
+    }
+}
+
+int main() {
+    struct Case {
+        std::string name;
+        BinaryImage image;
+    };
+    std::vector<Case> images;
+    for (int seed = 0; seed < 3; ++seed) {
+        images.push_back({"noise " + std::to_string(seed),
+                          BinaryImage::createNoise(29 + 14 * seed, 23 + 5 * seed, 0.2f, 0.5f, seed)});
+    }
+    images.push_back({"circle", BinaryImage::createCircle(37, 31, 9)});
+    images.push_back({"single pixel", BinaryImage(1, 1, true)});
+    images.push_back({"uniform", BinaryImage(19, 7, true)});
+
+    int failures = 0;
+    int cases = 0;
+    for (const Case& c : images) {
+        for (BoundaryMode boundary : kBoundaries) {
+            for (bool feature_value : {false, true}) {
+                DistanceField field = DistanceField::compute(c.image, boundary, feature_value);
+                bool same = field.width() == c.image.width() && field.height() == c.image.height();
+                for (int y = 0; same && y < c.image.height(); ++y) {
+                    for (int x = 0; same && x < c.image.width(); ++x) {
+                        same = field.get(x, y) == bruteForce(c.image, boundary, feature_value, x, y);
+                    }
+                }
+
+                ++cases;
+                if (!same) {
+                    std::printf("FAIL %s, boundary %d, features %d\n", c.name.c_str(),
+                                static_cast<int>(boundary), feature_value);
+                    ++failures;
+                }
+            }
+        }
+    }
+
+    std::printf("%d/%d distance fields match the brute-force search\n", cases - failures, cases);
+    return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,55 @@
+// A FillIndex query must cover exactly the pixels a completed FloodFill
+// from the same seed fills.
+
+#include "fill_index.hpp"
+#include "floodfill.hpp"
+#include <cstdio>
+#include <string>
+#include <vector>
+
+int main() {
+    struct Case {
+        std::string name;
+        BinaryImage image;
+    };
+    std::vector<Case> images;
+    for (int seed = 0; seed < 3; ++seed) {
+        images.push_back({"noise " + std::to_string(seed),
+                          BinaryImage::createNoise(45 + 7 * seed, 33 + 4 * seed, 0.2f, 0.5f, seed)});
+    }
+    images.push_back({"circle", BinaryImage::createCircle(41, 35, 12)});
+
+    int failures = 0;
+    int cases = 0;
+    for (const Case& c : images) {
+        int w = c.image.width();
+        int h = c.image.height();
+        for (Connectivity connectivity : {Connectivity::Four, Connectivity::Eight}) {
+            for (int radius = 0; radius <= 2; ++radius) {
+                FillIndex index(c.image, connectivity, radius);
+                FloodFill fill(connectivity, FillAlgorithm::Scanline, radius);
+
+                // Every seed, including unsafe ones and one outside the image
+                for (int i = -1; i < w * h; ++i) {
+                    int x = i < 0 ? w : i % w;
+                    int y = i < 0 ? 0 : i / w;
+                    FillRegion region = index.query(x, y);
+                    fill.initialize(c.image, x, y);
+                    while (fill.step()) {
+                    }
+
+                    ++cases;
+                    if (static_cast<size_t>(region.stats.area) != fill.getFilledCount() ||
+                        !(index.mask(region) == fill.getResult())) {
+                        std::printf("FAIL %s, %s-connected, radius %d, seed (%d, %d)\n", c.name.c_str(),
+                                    connectivity == Connectivity::Four ? "4" : "8", radius, x, y);
+                        ++failures;
+                    }
+                }
+            }
+        }
+    }
+
+    std::printf("%d/%d queries match the flood fill\n", cases - failures, cases);
+    return failures == 0 ? 0 : 1;
+}
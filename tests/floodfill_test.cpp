@@ -0,0 +1,106 @@
+// Switching the fill algorithm mid-fill, or finishing a copy of a fill,
+// must still reach exactly the pixels a fill that ran with a single
+// algorithm reaches.
+
+#include "floodfill.hpp"
+#include <cstdio>
+
+namespace {
+    const FillAlgorithm kAlgorithms[] = {
+        FillAlgorithm::BFS,
+        FillAlgorithm::DFS,
+        FillAlgorithm::Scanline,
+        FillAlgorithm::ParallelBFS
+    };
+
+    const char* name(FillAlgorithm algorithm) {
+        switch (algorithm) {
+            case FillAlgorithm::BFS: return "BFS";
+            case FillAlgorithm::DFS: return "DFS";
+            case FillAlgorithm::Scanline: return "Scanline";
+            case FillAlgorithm::ParallelBFS: return "ParallelBFS";
+        }
+        return "?";
+    }
+
+    bool sameFill(const FloodFill& a, const FloodFill& b, int width, int height) {
+        if (a.getFilledCount() != b.getFilledCount() || a.getUnsafeCount() != b.getUnsafeCount()) {
+            return false;
+        }
+        for (int y = 0; y < height; ++y) {
+            for (int x = 0; x < width; ++x) {
+                if (a.getState(x, y) != b.getState(x, y)) {
+                    return false;
+                }
+            }
+        }
+        return a.getResult() == b.getResult();
+    }
+}
+
+int main() {
+    int failures = 0;
+    int cases = 0;
+    for (int seed = 0; seed < 6; ++seed) {
+        BinaryImage image = BinaryImage::createNoise(48, 40, 0.2f, 0.45f, seed);
+        for (Connectivity connectivity : {Connectivity::Four, Connectivity::Eight}) {
+            for (int radius = 0; radius <= 1; ++radius) {
+                // Seed on a pixel where the fill starts
+                int start_x = -1;
+                int start_y = -1;
+                FloodFill reference(connectivity, FillAlgorithm::BFS, radius);
+                for (int i = 0; i < 48 * 40 && start_x < 0; ++i) {
+                    reference.initialize(image, i % 48, i / 48);
+                    if (reference.getFrontierSize() > 0) {
+                        start_x = i % 48;
+                        start_y = i / 48;
+                    }
+                }
+                if (start_x < 0) {
+                    continue;
+                }
+                while (reference.step()) {
+                }
+
+                for (FillAlgorithm from : kAlgorithms) {
+                    for (FillAlgorithm to : kAlgorithms) {
+                        for (size_t before : {1, 5, 40}) {
+                            FloodFill fill(connectivity, from, radius);
+                            fill.setThreadCount(3);
+                            fill.initialize(image, start_x, start_y);
+                            fill.step(before);
+                            fill.setAlgorithm(to);
+                            while (fill.step()) {
+                            }
+
+                            ++cases;
+                            if (!sameFill(fill, reference, 48, 40)) {
+                                std::printf("FAIL %s -> %s after %zu steps (seed %d, radius %d)\n",
+                                            name(from), name(to), before, seed, radius);
+                                ++failures;
+                            }
+                        }
+                    }
+
+                    // A copy taken mid-fill finishes on its own
+                    FloodFill original(connectivity, from, radius);
+                    original.setThreadCount(3);
+                    original.initialize(image, start_x, start_y);
+                    original.step(5);
+                    FloodFill copy(original);
+                    copy.setAlgorithm(FillAlgorithm::ParallelBFS);
+                    while (copy.step()) {
+                    }
+                    ++cases;
+                    if (!sameFill(copy, reference, 48, 40)) {
+                        std::printf("FAIL copy of %s (seed %d, radius %d)\n", name(from), seed, radius);
+                        ++failures;
+                    }
+                }
+            }
+        }
+    }
+
+    std::printf("%d/%d switched or copied fills fill exactly\n", cases - failures, cases);
+    return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,195 @@
+// Every engine and instruction set must give exactly the checkPixel()
+// result, through apply(), apply(input, output) and applyInPlace(), for
+// whole images and for views that start mid-word.
+
+#include "erosion.hpp"
+#include "row_kernels.hpp"
+#include <cstdio>
+#include <string>
+#include <vector>
+
+namespace {
+    const MorphEngine kEngines[] = {
+        MorphEngine::Auto,
+        MorphEngine::PerPixel,
+        MorphEngine::Bitwise,
+        MorphEngine::Separable,
+        MorphEngine::Lut
+    };
+
+    const SimdLevel kSimdLevels[] = {
+        SimdLevel::Scalar,
+        SimdLevel::SSE2,
+        SimdLevel::AVX2,
+        SimdLevel::AVX512
+    };
+
+    const BoundaryMode kBoundaries[] = {
+        BoundaryMode::Zero,
+        BoundaryMode::One,
+        BoundaryMode::Extend,
+        BoundaryMode::Wrap
+    };
+
+    const char* name(MorphEngine engine) {
+        switch (engine) {
+            case MorphEngine::Auto: return "Auto";
+            case MorphEngine::PerPixel: return "PerPixel";
+            case MorphEngine::Bitwise: return "Bitwise";
+            case MorphEngine::Separable: return "Separable";
+            case MorphEngine::Lut: return "Lut";
+        }
+        return "?";
+    }
+
+    StructuringElement rectangle(int width, int height) {
+        StructuringElement se{width, height, width / 2, height / 2, {}};
+        for (int dy = -height / 2; dy < height - height / 2; ++dy) {
+            for (int dx = -width / 2; dx < width - width / 2; ++dx) {
+                se.offsets.emplace_back(dx, dy);
+            }
+        }
+        return se;
+    }
+
+    struct Shape {
+        const char* label;
+        StructuringElement se;
+    };
+
+    // Fixed shapes (the 3x3 square also suits the table engine),
+    // rectangles long enough for the line kernels and an off-center shape
+    // that only the generic kernels handle
+    std::vector<Shape> shapes() {
+        StructuringElement skewed{6, 3, 3, 1, {{-3, 0}, {0, 0}, {2, -1}, {1, 1}}};
+        return {
+            {"square 3", StructuringElement::createSquare(3)},
+            {"square 7", StructuringElement::createSquare(7)},
+            {"cross 5", StructuringElement::createCross(5)},
+            {"disk 3", StructuringElement::createDisk(3)},
+            {"rect 11x3", rectangle(11, 3)},
+            {"rect 1x9", rectangle(1, 9)},
+            {"skewed", skewed}
+        };
+    }
+
+    // Noise with uniform blocks larger than a 64x64 tile, so the bitwise
+    // engine skips whole tiles
+    BinaryImage testImage(int width, int height, int seed) {
+        BinaryImage image = BinaryImage::createNoise(width, height, 0.2f, 0.5f, seed);
+        for (int y = 0; y < height; ++y) {
+            for (int x = 0; x < width; ++x) {
+                if (x < 150 && y < 140) {
+                    image.set(x, y, true);
+                } else if (x >= width - 140 && y >= height - 135) {
+                    image.set(x, y, false);
+                }
+            }
+        }
+        return image;
+    }
+
+    BinaryImage reference(const Morphology& morph, const BinaryImageView& input) {
+        BinaryImage expected(input.width(), input.height(), false);
+        for (int y = 0; y < input.height(); ++y) {
+            for (int x = 0; x < input.width(); ++x) {
+                expected.set(x, y, morph.checkPixel(input, x, y));
+            }
+        }
+        return expected;
+    }
+
+    struct Counts {
+        int cases = 0;
+        int failures = 0;
+    };
+
+    // Run every engine, instruction set and thread count against the
+    // checkPixel() result of one operation on one input
+    void checkAll(Morphology& morph, const BinaryImageView& input, const std::string& label, Counts& counts) {
+        morph.setEngine(MorphEngine::PerPixel);
+        BinaryImage expected = reference(morph, input);
+        BinaryImage output(3, 3, false);
+
+        for (SimdLevel level : kSimdLevels) {
+            if (setSimdLevel(level) != level) {
+                continue;
+            }
+            for (MorphEngine engine : kEngines) {
+                for (int threads : {1, 3}) {
+                    morph.setEngine(engine);
+                    morph.setThreadCount(threads);
+
+                    auto check = [&](const char* how, const BinaryImageView& result) {
+                        ++counts.cases;
+                        if (!(expected == result)) {
+                            std::printf("FAIL %s: %s, %s, %s, %d threads\n", label.c_str(), how, name(engine),
+                                        simdLevelName(level), threads);
+                            ++counts.failures;
+                        }
+                    };
+                    check("apply", morph.apply(input));
+                    morph.apply(input, output);
+                    check("apply into", output);
+                    BinaryImage in_place(input);
+                    morph.applyInPlace(in_place);
+                    check("applyInPlace", in_place);
+                }
+            }
+        }
+        setSimdLevel(detectSimdLevel());
+        morph.setThreadCount(1);
+    }
+}
+
+int main() {
+    const MorphOperation single_pass[] = {
+        MorphOperation::Erosion,
+        MorphOperation::Dilation,
+        MorphOperation::InnerBoundary,
+        MorphOperation::OuterBoundary,
+        MorphOperation::Gradient
+    };
+    const MorphOperation chained[] = {
+        MorphOperation::Opening,
+        MorphOperation::Closing,
+        MorphOperation::WhiteTopHat,
+        MorphOperation::BlackTopHat,
+        MorphOperation::Gradient
+    };
+
+    // Neither size is a multiple of 64; the views start 37 bits into a word
+    BinaryImage large = testImage(333, 301, 1);
+    BinaryImage small = testImage(91, 67, 2);
+    BinaryImageView large_view = large.view(37, 5, 290, 283);
+    BinaryImageView small_view = small.view(37, 3, 50, 61);
+
+    Counts counts;
+    for (const Shape& shape : shapes()) {
+        for (BoundaryMode boundary : kBoundaries) {
+            std::string where = std::string(shape.label) + ", boundary " +
+                                std::to_string(static_cast<int>(boundary));
+            for (MorphOperation op : single_pass) {
+                Morphology morph(shape.se, op, boundary);
+                std::string label = where + ", op " + std::to_string(static_cast<int>(op));
+                checkAll(morph, large, label, counts);
+                checkAll(morph, large_view, label + ", view", counts);
+            }
+
+            // Several passes, also from repeated erosions and dilations
+            for (MorphOperation op : chained) {
+                for (int iterations : {1, 2}) {
+                    Morphology morph(shape.se, op, boundary);
+                    morph.setIterations(iterations);
+                    std::string label = where + ", op " + std::to_string(static_cast<int>(op)) + " x" +
+                                        std::to_string(iterations);
+                    checkAll(morph, small, label, counts);
+                    checkAll(morph, small_view, label + ", view", counts);
+                }
+            }
+        }
+    }
+
+    std::printf("%d/%d engine results match checkPixel\n", counts.cases - counts.failures, counts.cases);
+    return counts.failures == 0 ? 0 : 1;
+}